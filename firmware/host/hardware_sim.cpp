@@ -0,0 +1,682 @@
+/* Simulated implementation of hardware.hpp for the host build.
+
+   Time is virtual: timer interrupts are emulated in order of their
+   timestamps, so hours of tracking run in seconds. Simulation is
+   controlled by environment variables:
+
+   SIM_HOURS         duration of simulation in hours (8 by default)
+   SIM_SEED          value returned by get_value_for_srand()
+   SIM_QUIET         if set, debug UART output is suppressed
+   SIM_SHOW_DISPLAY  if set, display content is printed at the end
+   SIM_PRESS         button presses: name:start_ms:duration_ms[,...]
+                     where name is revert, dither_time or dither_angle
+                     (contacts bounce for a few ms at press and release) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <chrono>
+
+#include "hardware.hpp"
+#include "step_speed.hpp"
+#include "profiling.hpp"
+#include "debug_printf.hpp"
+#include "mgfxpp/displays/mono_sh1106.hpp"
+#include "mgfxpp/mgfxpp_display.hpp"
+#include "sim_display_conn.hpp"
+
+// virtual time in microseconds spent by each call to counters getters
+// (so busy loops without delay_ms are moving forward in time too)
+constexpr uint64_t PollCostUs = 20;
+
+constexpr uint64_t NoTime = ~(uint64_t)0;
+
+constexpr unsigned SimBounceMs = 3;
+
+// step timer tick in microseconds of virtual time
+constexpr uint32_t StepTimerTickUs = 1'000'000 / TimerClock;
+
+struct SimPress
+{
+	ButtonId button;
+	unsigned start_ms;
+	unsigned duration_ms;
+};
+
+static StepSpeed step_speed;
+
+static bool step_timer_enabled = false;
+static unsigned time_counter = 0;
+static unsigned calc_steps_timer_cnt = 0;
+static unsigned timer_event_time = 0;
+static bool timer_event_set = false;
+
+static EventQueue event_queue;
+
+// virtual time from wake up to sleep is counted as busy
+static uint64_t busy_us = 0;
+static uint64_t awake_start_us = 0;
+static uint32_t wakeups_count = 0;
+static bool step_counter_irq = false; // emulated compare interrupt wakes up sleep
+
+static int32_t steps_counter = 0;
+static int32_t step_pulses = 0;
+static uint16_t step_counter_prev = 0;
+static uint32_t step_period_us = 1000;
+static bool dir_pin = false;
+
+// emulated timer counting step pulses and its compare interrupt
+static uint16_t step_counter = 0;
+static bool step_counter_down = false;
+static uint16_t step_counter_cc = 0;
+static bool step_counter_cc_enabled = false;
+
+static uint16_t step_intervals[StepScheduleSize] = {};
+static unsigned step_intervals_wr_pos = 0;
+static unsigned step_intervals_rd_pos = 0; // position of emulated DMA
+static bool step_schedule_running = false;
+static bool step_schedule_limited = false;
+static int32_t step_schedule_end = 0;
+static int32_t step_schedule_start = 0;
+static uint32_t step_intervals_added = 0;
+static uint32_t step_schedule_underruns = 0;  // steps made by intervals not written yet
+
+static uint64_t sim_time_us = 0;
+static uint64_t sim_end_us = 0;
+static uint64_t next_tick_us = 1000;
+static uint64_t next_step_us = NoTime;
+
+static constexpr unsigned MaxPresses = 32;
+static SimPress presses[MaxPresses];
+static unsigned presses_count = 0;
+
+static uint32_t srand_value = 1;
+static bool uart_quiet = false;
+
+// emulated debug UART transmit buffer (only its fill level)
+static unsigned uart_tx_used = 0;
+static unsigned uart_tx_credit = 0; // in 1/TimeTimerFreq of character
+static uint32_t uart_tx_dropped = 0;
+static bool show_display = false;
+static std::chrono::steady_clock::time_point wall_start;
+
+static void sim_finish();
+
+/* Simulated peripherals */
+
+// contacts bounce for SimBounceMs after press and release
+static bool is_sim_btn_pressed(ButtonId button)
+{
+	for (unsigned i = 0; i < presses_count; i++)
+	{
+		const auto &press = presses[i];
+		if (press.button != button) continue;
+		unsigned end_ms = press.start_ms + press.duration_ms;
+		if ((time_counter >= press.start_ms) && (time_counter < press.start_ms + SimBounceMs))
+			return (time_counter - press.start_ms) % 2 == 0;
+		if ((time_counter >= end_ms) && (time_counter < end_ms + SimBounceMs))
+			return (time_counter - end_ms) % 2 == 1;
+		if ((time_counter >= press.start_ms) && (time_counter < end_ms))
+			return true;
+	}
+	return false;
+}
+
+// emulated EXTI lines of buttons (edges are seen at time ticks)
+static bool exti_enabled[(unsigned)ButtonId::Count] = { true, true, true };
+static bool exti_level[(unsigned)ButtonId::Count] = {};
+
+struct SimButtonPort
+{
+	static bool is_pressed(unsigned button)
+	{
+		return is_sim_btn_pressed((ButtonId)button);
+	}
+
+	static void enable_edge_irq(unsigned button)
+	{
+		exti_enabled[button] = true;
+		exti_level[button] = is_pressed(button);
+	}
+
+	static void disable_edge_irq(unsigned button)
+	{
+		exti_enabled[button] = false;
+	}
+
+	static void notify()
+	{
+		event_queue.post(Event::Button);
+	}
+};
+
+static ButtonEngine<SimButtonPort, TimeTimerFreq> buttons;
+
+static void update_steps_counter()
+{
+	int16_t diff = (int16_t)(step_counter - step_counter_prev);
+	step_counter_prev = step_counter;
+	step_pulses += diff;
+
+	steps_counter += diff;
+	if (steps_counter < 0)
+		steps_counter = 0;
+}
+
+static void set_step_dir(bool forward)
+{
+	dir_pin = forward;
+	step_counter_down = !forward;
+}
+
+static void calc_steps_timer_period()
+{
+	ProfScope prof_scope(ProfSection::CalcStepsPeriod);
+
+	if (step_speed.update())
+	{
+		step_period_us = step_speed.get_reload_value() * StepTimerTickUs;
+		set_step_dir(step_speed.is_forward());
+
+		if (!step_timer_enabled)
+		{
+			next_step_us = sim_time_us + step_period_us;
+			step_timer_enabled = true;
+		}
+	}
+	else if (step_timer_enabled)
+	{
+		next_step_us = NoTime;
+		step_timer_enabled = false;
+	}
+}
+
+static void check_step_schedule_underrun();
+
+static void time_timer_isr()
+{
+	ProfScope prof_scope(ProfSection::TimeTimerIsr);
+
+	++time_counter;
+
+	update_steps_counter();
+	check_step_schedule_underrun();
+
+	for (unsigned i = 0; i < (unsigned)ButtonId::Count; i++)
+	{
+		bool level = is_sim_btn_pressed((ButtonId)i);
+		if (level == exti_level[i]) continue;
+		exti_level[i] = level;
+		if (exti_enabled[i]) buttons.on_edge(i, time_counter);
+	}
+	buttons.tick(time_counter);
+
+	if (timer_event_set && ((int32_t)(time_counter - timer_event_time) >= 0))
+	{
+		timer_event_set = false;
+		event_queue.post(Event::Timer);
+	}
+
+	// 10 bits per character are sent by UART
+	uart_tx_credit += DebugUartBaudRate / 10;
+	unsigned uart_sent = uart_tx_credit / TimeTimerFreq;
+	if (uart_sent >= uart_tx_used)
+	{
+		uart_tx_used = 0;
+		uart_tx_credit = 0;
+	}
+	else
+	{
+		uart_tx_used -= uart_sent;
+		uart_tx_credit -= uart_sent * TimeTimerFreq;
+	}
+
+	++calc_steps_timer_cnt;
+	if (calc_steps_timer_cnt >= TimeTimerFreq/RecalcMotorSpeedFreq)
+	{
+		if (!step_schedule_running)
+			calc_steps_timer_period();
+		calc_steps_timer_cnt = 0;
+	}
+
+	if (sim_time_us >= sim_end_us)
+		sim_finish();
+}
+
+static void finish_step_schedule();
+
+static void step_counter_isr()
+{
+	ProfScope prof_scope(ProfSection::StepCounterIsr);
+
+	step_counter_irq = true;
+	update_steps_counter();
+
+	if (step_schedule_limited && (step_pulses == step_schedule_end))
+		finish_step_schedule();
+}
+
+// step pulse is counted by timer without interrupt
+static void count_step_pulse()
+{
+	step_counter += step_counter_down ? -1 : 1;
+	if (step_counter_cc_enabled && (step_counter == step_counter_cc))
+		step_counter_isr();
+}
+
+static void sim_advance_to(uint64_t time_us)
+{
+	for (;;)
+	{
+		uint64_t next = (next_tick_us < next_step_us) ? next_tick_us : next_step_us;
+		if (next > time_us) break;
+
+		sim_time_us = next;
+
+		if (next == next_step_us)
+		{
+			if (step_schedule_running)
+			{
+				step_period_us = (step_intervals[step_intervals_rd_pos] + 1) * StepTimerTickUs;
+				step_intervals_rd_pos = (step_intervals_rd_pos + 1) % StepScheduleSize;
+			}
+
+			count_step_pulse();
+			next_step_us = step_timer_enabled ? (next_step_us + step_period_us) : NoTime;
+		}
+
+		if (next == next_tick_us)
+		{
+			next_tick_us += 1'000'000 / TimeTimerFreq;
+			time_timer_isr();
+		}
+	}
+
+	sim_time_us = time_us;
+}
+
+/* Simulation setup and results */
+
+static bool parse_press(const char* text, SimPress &press)
+{
+	char name[32] = {};
+	unsigned start_ms = 0;
+	unsigned duration_ms = 0;
+	if (sscanf(text, "%31[a-z_]:%u:%u", name, &start_ms, &duration_ms) != 3)
+		return false;
+
+	if (strcmp(name, "revert") == 0)
+		press.button = ButtonId::Revert;
+	else if (strcmp(name, "dither_time") == 0)
+		press.button = ButtonId::DitherTime;
+	else if (strcmp(name, "dither_angle") == 0)
+		press.button = ButtonId::DitherAngle;
+	else
+		return false;
+
+	press.start_ms = start_ms;
+	press.duration_ms = duration_ms;
+	return true;
+}
+
+static void sim_init()
+{
+	double hours = 8.0;
+	if (const char* text = getenv("SIM_HOURS"))
+		hours = atof(text);
+	sim_end_us = (uint64_t)(hours * 3600.0 * 1e6);
+
+	if (const char* text = getenv("SIM_SEED"))
+		srand_value = strtoul(text, nullptr, 0);
+
+	uart_quiet = getenv("SIM_QUIET") != nullptr;
+	show_display = getenv("SIM_SHOW_DISPLAY") != nullptr;
+
+	if (const char* text = getenv("SIM_PRESS"))
+	{
+		for (const char* item = text; item && *item && (presses_count < MaxPresses);)
+		{
+			if (parse_press(item, presses[presses_count]))
+				presses_count++;
+			else
+				fprintf(stderr, "SIM_PRESS: wrong item %s\n", item);
+
+			item = strchr(item, ',');
+			if (item) item++;
+		}
+	}
+
+	wall_start = std::chrono::steady_clock::now();
+}
+
+static void print_display_ram()
+{
+	for (unsigned y = 0; y < SimDisplayConn::RamPages * 8; y++)
+	{
+		for (unsigned x = 2; x < SimDisplayConn::RamWidth - 2; x++)
+		{
+			bool pixel = SimDisplayConn::get_ram(y / 8, x) & (1 << (y % 8));
+			fputc(pixel ? '#' : '.', stderr);
+		}
+		fputc('\n', stderr);
+	}
+}
+
+static void sim_finish()
+{
+	auto wall_time = std::chrono::steady_clock::now() - wall_start;
+	double wall_secs = std::chrono::duration<double>(wall_time).count();
+	double sim_secs = sim_time_us / 1e6;
+
+	fflush(stdout);
+
+	if (show_display)
+		print_display_ram();
+
+	fprintf(stderr, "--- simulation finished\n");
+	fprintf(stderr, "virtual time     = %.1f s\n", sim_secs);
+	fprintf(stderr, "wall time        = %.3f s (x%.0f)\n", wall_secs, wall_secs > 0 ? sim_secs / wall_secs : 0.0);
+	fprintf(stderr, "steps counter    = %d\n", (int)steps_counter);
+	fprintf(stderr, "rod len          = %.4f mm\n", steps_counter * RodStep * TurnsOnStep + StartL);
+	fprintf(stderr, "uart dropped     = %u chars\n", (unsigned)uart_tx_dropped);
+	fprintf(stderr, "sched underruns  = %u\n", (unsigned)step_schedule_underruns);
+	fprintf(stderr, "cpu busy         = %.2f %% (%u wakeups)\n", sim_time_us ? 100.0 * busy_us / sim_time_us : 0.0, (unsigned)wakeups_count);
+	fprintf(stderr, "display commands = %u\n", (unsigned)SimDisplayConn::get_commands_count());
+	fprintf(stderr, "display data     = %u bytes\n", (unsigned)SimDisplayConn::get_data_bytes_count());
+
+	exit(0);
+}
+
+/* hardware.hpp interface */
+
+void init_hardware()
+{
+	sim_init();
+
+	debug_printf("Hardware initialized\n");
+	debug_printf("Simulation for {} s\n", (unsigned)(sim_end_us / 1'000'000));
+}
+
+static void stop_step_schedule()
+{
+	if (!step_schedule_running) return;
+
+	step_speed.continue_schedule(step_period_us / StepTimerTickUs, dir_pin);
+
+	step_schedule_running = false;
+
+	step_counter_cc_enabled = false;
+	step_schedule_limited = false;
+}
+
+static void finish_step_schedule()
+{
+	next_step_us = NoTime;
+	step_timer_enabled = false;
+
+	stop_step_schedule();
+	step_speed.stop();
+
+	event_queue.post(Event::MoveDone);
+}
+
+void set_rotations_per_seconds(float value)
+{
+	stop_step_schedule();
+	step_speed.set_desired(value);
+}
+
+float get_desired_rotations_per_seconds()
+{
+	return step_speed.get_desired();
+}
+
+float get_rotations_per_seconds()
+{
+	if (!step_schedule_running) return step_speed.get();
+
+	return StepSpeed::calc_speed(step_period_us / StepTimerTickUs, dir_pin);
+}
+
+void reset_step_schedule()
+{
+	stop_step_schedule();
+
+	next_step_us = NoTime;
+	step_timer_enabled = false;
+	step_speed.stop();
+
+	step_intervals_wr_pos = 0;
+	step_intervals_rd_pos = 0;
+	step_intervals_added = 0;
+}
+
+unsigned get_step_schedule_free_space()
+{
+	unsigned used = (step_intervals_wr_pos + StepScheduleSize - step_intervals_rd_pos) % StepScheduleSize;
+	return StepScheduleSize - used - 1;
+}
+
+bool add_step_interval(uint16_t interval)
+{
+	if (get_step_schedule_free_space() == 0) return false;
+	step_intervals[step_intervals_wr_pos] = interval - 1;
+	step_intervals_wr_pos = (step_intervals_wr_pos + 1) % StepScheduleSize;
+	step_intervals_added++;
+	return true;
+}
+
+void run_step_schedule(uint16_t first_interval, bool forward, uint32_t steps_count)
+{
+	stop_step_schedule();
+	set_step_dir(forward);
+
+	update_steps_counter();
+	step_schedule_start = step_pulses;
+
+	if (steps_count)
+	{
+		int32_t diff = forward ? (int32_t)steps_count : -(int32_t)steps_count;
+		step_schedule_end = step_pulses + diff;
+		step_schedule_limited = true;
+		step_counter_cc = (uint16_t)(step_counter_prev + diff);
+		step_counter_cc_enabled = true;
+	}
+
+	step_intervals_rd_pos = 0;
+	step_period_us = first_interval * StepTimerTickUs;
+	next_step_us = sim_time_us + step_period_us;
+	step_timer_enabled = true;
+	step_schedule_running = true;
+}
+
+bool is_step_schedule_running()
+{
+	return step_schedule_running;
+}
+
+uint32_t get_step_schedule_underruns()
+{
+	return step_schedule_underruns;
+}
+
+// same detection as on target: each step takes next interval from ring
+static void check_step_schedule_underrun()
+{
+	if (!step_schedule_running) return;
+
+	int32_t steps = step_pulses - step_schedule_start;
+	uint32_t steps_made = (steps < 0) ? -steps : steps;
+	if (steps_made <= step_intervals_added) return;
+	if (step_schedule_limited && (step_pulses == step_schedule_end)) return;
+
+	step_schedule_underruns++;
+	stop_step_schedule();
+	step_speed.set_desired(0);
+}
+
+void send_debug_uart_char(char chr)
+{
+	if (uart_tx_used >= DebugUartBufferSize - 1)
+	{
+		uart_tx_dropped++;
+		return;
+	}
+
+	uart_tx_used++;
+	if (!uart_quiet) putchar(chr);
+}
+
+size_t send_debug_uart_text(const char* text, size_t len)
+{
+	unsigned free_space = DebugUartBufferSize - 1 - uart_tx_used;
+	if (len > free_space)
+	{
+		uart_tx_dropped += len - free_space;
+		len = free_space;
+	}
+
+	uart_tx_used += len;
+	if (!uart_quiet) fwrite(text, 1, len, stdout);
+
+	return len;
+}
+
+uint32_t get_debug_uart_dropped_count()
+{
+	return uart_tx_dropped;
+}
+
+size_t get_debug_uart_free_space()
+{
+	return DebugUartBufferSize - 1 - uart_tx_used;
+}
+
+bool is_button_pressed(ButtonId button)
+{
+	return buttons.is_pressed((unsigned)button);
+}
+
+bool get_button_event(ButtonEvent &event)
+{
+	return buttons.get_event(event);
+}
+
+unsigned get_time_counter()
+{
+	sim_advance_to(sim_time_us + PollCostUs);
+	return time_counter;
+}
+
+// sleeps until next time tick. Step pulses are counted without interrupt,
+// only compare interrupt at the end of move can wake up before the tick
+static void sleep_until_interrupt()
+{
+	busy_us += sim_time_us - awake_start_us;
+	step_counter_irq = false;
+	while (!step_counter_irq && (next_step_us < next_tick_us))
+		sim_advance_to(next_step_us);
+	if (!step_counter_irq)
+		sim_advance_to(next_tick_us);
+	awake_start_us = sim_time_us;
+	wakeups_count++;
+}
+
+Event wait_event()
+{
+	for (;;)
+	{
+		Event event = event_queue.get();
+		if (event != Event::None) return event;
+		sleep_until_interrupt();
+	}
+}
+
+void set_timer_event(unsigned time_counter)
+{
+	timer_event_time = time_counter;
+	timer_event_set = true;
+}
+
+void delay_ms(unsigned delay_in_ms)
+{
+	auto start_cnt = time_counter;
+	auto max_diff = delay_in_ms * 1000U / TimeTimerFreq;
+	while ((time_counter - start_cnt) < max_diff)
+		sleep_until_interrupt();
+}
+
+uint64_t get_cpu_busy_us()
+{
+	return busy_us + (sim_time_us - awake_start_us);
+}
+
+void led_on() {}
+
+void led_off() {}
+
+int32_t get_steps_counter()
+{
+	sim_advance_to(sim_time_us + PollCostUs);
+	update_steps_counter();
+	return steps_counter;
+}
+
+uint32_t get_value_for_srand()
+{
+	return srand_value;
+}
+
+uint32_t get_cycles_counter()
+{
+	auto time = std::chrono::steady_clock::now().time_since_epoch();
+	return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+}
+
+
+using DisplayConn = SimDisplayConn;
+using Display = mgfxpp::sh1106_display<DisplayConn>;
+using BufferedDisplay = mgfxpp::MonoBufferedDisplay<Display>;
+
+MGFXPP_DISPLAY_BUFFERED_IMPL(BufferedDisplay)
+
+static bool display_is_initialized = false;
+
+void init_display()
+{
+	debug_printf("Initializing display... ");
+
+	uint32_t errors_count = DisplayConn::get_errors_count();
+	display_is_initialized =
+		Display::init(false) &&
+		DisplayConn::wait_transfer_finished() &&
+		(DisplayConn::get_errors_count() == errors_count);
+
+	debug_printf("{}\n", display_is_initialized ? "OK" : "FAILED!");
+
+	if (!display_is_initialized) return;
+
+	Display::set_brightness(0x20);
+
+	mgfxpp::display_draw([]
+	{
+		mgfxpp::display_fill_rect(mgfxpp::display_get_clip_rect(), mgfxpp::Color::PixelOff);
+	});
+}
+
+bool is_display_ok()
+{
+	return display_is_initialized;
+}
+
+uint32_t get_display_errors_count()
+{
+	return DisplayConn::get_errors_count();
+}
+
+bool is_display_busy()
+{
+	return !DisplayConn::is_transfer_finished();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/* Display connector for host simulation. Decodes SH1106 page/column
+   commands and keeps a copy of controller memory */
+
+class SimDisplayConn
+{
+public:
+	static constexpr unsigned RamWidth = 132;
+	static constexpr unsigned RamPages = 8;
+
+	static bool send_command(uint8_t cmd)
+	{
+		commands_count_++;
+
+		if (arg_cmd_count_)
+		{
+			arg_cmd_count_--;
+			return true;
+		}
+
+		if ((cmd & 0xF0) == 0xB0)
+			page_ = cmd & 0x0F;
+		else if ((cmd & 0xF0) == 0x10)
+			col_ = (col_ & 0x0F) | ((cmd & 0x0F) << 4);
+		else if ((cmd & 0xF0) == 0x00)
+			col_ = (col_ & 0xF0) | (cmd & 0x0F);
+		else if ((cmd == 0x81) || (cmd == 0x20) || (cmd == 0xA8) || (cmd == 0xD3) ||
+		         (cmd == 0xD5) || (cmd == 0xD9) || (cmd == 0xDA) || (cmd == 0xDB) ||
+		         (cmd == 0x8D))
+			arg_cmd_count_ = 1;
+
+		return true;
+	}
+
+	static bool send_data(uint8_t data)
+	{
+		data_bytes_count_++;
+		if ((page_ < RamPages) && (col_ < RamWidth))
+			ram_[page_][col_] = data;
+		col_++;
+		return true;
+	}
+
+	static void finish_send_data() {}
+
+	static bool is_transfer_finished()
+	{
+		return true;
+	}
+
+	static bool wait_transfer_finished()
+	{
+		return true;
+	}
+
+	static uint32_t get_errors_count()
+	{
+		return 0;
+	}
+
+	static uint8_t get_ram(unsigned page, unsigned col)
+	{
+		return ram_[page][col];
+	}
+
+	static uint32_t get_commands_count()
+	{
+		return commands_count_;
+	}
+
+	static uint32_t get_data_bytes_count()
+	{
+		return data_bytes_count_;
+	}
+
+private:
+	inline static uint8_t ram_[RamPages][RamWidth] = {};
+	inline static unsigned page_ = 0;
+	inline static unsigned col_ = 0;
+	inline static unsigned arg_cmd_count_ = 0;
+	inline static uint32_t commands_count_ = 0;
+	inline static uint32_t data_bytes_count_ = 0;
+};
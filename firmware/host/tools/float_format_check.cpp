@@ -0,0 +1,182 @@
+/* Check and benchmark of float formatting in micro_format.
+
+   mf::format_float() is compared with snprintf("%.*f") (correctly rounded
+   by glibc) on random values of different magnitudes and on exact ties.
+   Previous digit-by-digit formatter (copied below as reference) is
+   checked the same way to show the difference. Prints time of one call */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits>
+#include <chrono>
+
+#include "mgfxpp/micro_format.hpp"
+
+constexpr unsigned RandomValuesCount = 1'000'000;
+constexpr int MaxPrecision = 8;
+
+/* Previous formatter: double multiplies and divides by 10 per digit */
+
+static void reference_format_float(char *buffer, double value, int precision)
+{
+	auto put_char = [&](char chr) { *buffer++ = chr; };
+
+	if (value < 0)
+	{
+		put_char('-');
+		value = -value;
+	}
+
+	double round_div = 1.0;
+	for (int i = 0; i < precision; i++) round_div *= 10.0;
+
+	double rounded_value = value + 0.5 / round_div;
+
+	int integral_len = 0;
+	double integral_div = 1;
+	if (value >= 1.0)
+	{
+		while (value > integral_div)
+		{
+			integral_div *= 10.0;
+			integral_len++;
+		}
+		if ((int)(value / integral_div) == 0)
+			integral_div /= 10.0;
+		else
+			integral_len++;
+	}
+	else
+	{
+		integral_len = 1;
+	}
+
+	double rest = rounded_value;
+	while (integral_len--)
+	{
+		int int_val = (int)(rest / integral_div);
+		put_char('0' + int_val);
+		rest -= int_val * integral_div;
+		integral_div /= 10.0;
+	}
+
+	double integral_part = 0;
+	rest = modf(value, &integral_part);
+
+	if (precision)
+		put_char('.');
+
+	for (int i = 0; i < precision; i++)
+	{
+		rest *= 10.0;
+		round_div /= 10.0;
+		int int_val = (int)(rest + 0.5 / round_div);
+		rest -= int_val;
+		if (int_val >= 10) int_val -= 10;
+		put_char('0' + int_val);
+	}
+
+	*buffer = 0;
+}
+
+static double random_value()
+{
+	double mantissa = (double)rand() / RAND_MAX;
+	int exponent = rand() % 14 - 6;
+	double value = mantissa * pow(10.0, exponent);
+	return (rand() & 1) ? -value : value;
+}
+
+// value exactly in the middle between two decimal results
+static double random_tie(int precision)
+{
+	// k/2^n are exact in binary, tie for precision p if n = p+1
+	int n = precision + 1;
+	double value = (double)(rand() % 100000) + (2 * (rand() % (1 << (n - 1))) + 1) / (double)(1 << n);
+	return (rand() & 1) ? -value : value;
+}
+
+struct CheckResult
+{
+	unsigned count = 0;
+	unsigned new_errors = 0;
+	unsigned ref_errors = 0;
+};
+
+static void check_value(double value, int precision, CheckResult &result, bool print_ref_errors)
+{
+	char expected[64], new_text[64], ref_text[64];
+	snprintf(expected, sizeof(expected), "%.*f", precision, value);
+	mf::format_float(new_text, value, precision);
+	reference_format_float(ref_text, value, precision);
+
+	result.count++;
+
+	if (strcmp(expected, new_text) != 0)
+	{
+		if (result.new_errors < 10)
+			printf("  MISMATCH %.17g p=%d: snprintf \"%s\", format_float \"%s\"\n", value, precision, expected, new_text);
+		result.new_errors++;
+	}
+
+	if (strcmp(expected, ref_text) != 0)
+	{
+		if (print_ref_errors && (result.ref_errors < 3))
+			printf("  previous formatter: %.17g p=%d: snprintf \"%s\", previous \"%s\"\n", value, precision, expected, ref_text);
+		result.ref_errors++;
+	}
+}
+
+template <typename Fun>
+static double measure_ns(const Fun &fun)
+{
+	constexpr unsigned count = 200000;
+	double best = 1e9;
+
+	for (unsigned pass = 0; pass < 5; pass++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < count; i++)
+		{
+			fun(19.01444 + i * 1e-5);
+			asm volatile("" : : : "memory");
+		}
+		auto time = std::chrono::steady_clock::now() - start;
+		double ns = std::chrono::duration<double, std::nano>(time).count() / count;
+		if (ns < best) best = ns;
+	}
+
+	return best;
+}
+
+int main()
+{
+	srand(1);
+
+	CheckResult random_result;
+	CheckResult tie_result;
+
+	printf("Random values:\n");
+	for (unsigned i = 0; i < RandomValuesCount; i++)
+		check_value(random_value(), rand() % (MaxPrecision + 1), random_result, true);
+
+	printf("Exact ties:\n");
+	for (unsigned i = 0; i < RandomValuesCount / 10; i++)
+		check_value(random_tie(rand() % (MaxPrecision + 1)), rand() % (MaxPrecision + 1), tie_result, true);
+
+	printf("\n%-14s %10s %14s %14s\n", "values", "count", "format_float", "previous");
+	printf("%-14s %10u %14u %14u\n", "random", random_result.count, random_result.new_errors, random_result.ref_errors);
+	printf("%-14s %10u %14u %14u\n", "ties", tie_result.count, tie_result.new_errors, tie_result.ref_errors);
+	printf("(number of results different from snprintf)\n\n");
+
+	char buffer[64];
+	double new_ns = measure_ns([&](double value) { mf::format_float(buffer, value, 5); });
+	double ref_ns = measure_ns([&](double value) { reference_format_float(buffer, value, 5); });
+	double std_ns = measure_ns([&](double value) { snprintf(buffer, sizeof(buffer), "%.5f", value); });
+
+	printf("Time of {:.5} for angle values, ns: format_float %.1f, previous %.1f, snprintf %.1f\n", new_ns, ref_ns, std_ns);
+
+	return (random_result.new_errors || tie_result.new_errors) ? 1 : 0;
+}
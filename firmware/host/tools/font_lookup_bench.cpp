@@ -0,0 +1,97 @@
+/* Glyph lookup benchmark: range table (direct index) against binary
+   search for sorted fonts and linear scan for unsorted ones.
+
+   Checks that all lookups give the same character for codes 0..0x2FFF
+   and prints time of one lookup for text made of font characters */
+
+#include <stdio.h>
+#include <chrono>
+
+#include "mgfxpp_font.hpp"
+#include "fonts/font_roboto_bold11_en.hpp"
+#include "mgfxpp/fonts/font_simple8_ru.hpp"
+
+using namespace mgfxpp;
+
+constexpr uint32_t MaxCheckCode = 0x2FFF;
+constexpr unsigned Repeats = 2000;
+
+static Font without_flags(const Font &font, uint8_t flags)
+{
+	Font result = font;
+	result.flags &= ~flags;
+	return result;
+}
+
+static bool check_lookup(const Font &font, const Font &ref_font)
+{
+	for (uint32_t code = 0; code <= MaxCheckCode; code++)
+	{
+		if (font_find_charaster(font, code) != font_find_charaster(ref_font, code))
+		{
+			printf("lookup mismatch for code %u\n", (unsigned)code);
+			return false;
+		}
+	}
+	return true;
+}
+
+static double measure_lookup(const Font &font, const Font &chars_font)
+{
+	const Character* sink = nullptr;
+	double best = 1e9;
+
+	for (unsigned pass = 0; pass < 5; pass++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned r = 0; r < Repeats; r++)
+		{
+			for (unsigned i = 0; i < chars_font.charaster_count; i++)
+			{
+				auto *chr = font_find_charaster(font, chars_font.characters[i].char_code);
+				asm volatile("" : : "r"(chr) : "memory");
+				sink = chr;
+			}
+		}
+		auto time = std::chrono::steady_clock::now() - start;
+		double ns = std::chrono::duration<double, std::nano>(time).count();
+		ns /= (double)Repeats * chars_font.charaster_count;
+		if (ns < best) best = ns;
+	}
+
+	(void)sink;
+	return best;
+}
+
+static bool bench_font(const char *name, const Font &font, bool has_linear)
+{
+	const Font sorted = without_flags(font, FONT_FLAG_CHARS_RANGES);
+	const Font linear = without_flags(font, FONT_FLAG_CHARS_RANGES | FONT_FLAG_CHARS_SORTED);
+
+	bool ok = check_lookup(font, sorted);
+	if (has_linear) ok &= check_lookup(font, linear);
+
+	printf("%-16s %8u %8u %10.2f %10.2f", name, (unsigned)font.charaster_count, (unsigned)font.range_count,
+		measure_lookup(font, font), measure_lookup(sorted, font));
+
+	if (has_linear)
+		printf(" %10.2f", measure_lookup(linear, font));
+	else
+		printf(" %10s", "-");
+
+	printf("   %s\n", ok ? "OK" : "FAILED");
+
+	return ok;
+}
+
+int main()
+{
+	printf("Glyph lookup time, ns per character\n\n");
+	printf("%-16s %8s %8s %10s %10s %10s\n", "font", "chars", "ranges", "range", "binary", "linear");
+
+	bool ok = true;
+	ok &= bench_font("roboto_bold11", font_roboto_bold11_en, false);
+	ok &= bench_font("simple8_ru", font_simple8_ru, true);
+
+	return ok ? 0 : 1;
+}
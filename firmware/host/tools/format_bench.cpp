@@ -0,0 +1,167 @@
+/* Benchmark of mf::format: format string parsed at runtime against
+   compile-time parsed one (MF_FMT). Both must give the same text.
+   snprintf is shown for reference. Second table compares output by
+   character callback against text callback receiving whole runs */
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include "mgfxpp/micro_format.hpp"
+
+constexpr unsigned Repeats = 20000;
+
+template <typename Fun>
+static double measure_ns(const Fun &fun)
+{
+	double best = 1e9;
+
+	for (unsigned pass = 0; pass < 5; pass++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < Repeats; i++)
+		{
+			fun(i);
+			asm volatile("" : : : "memory");
+		}
+		auto time = std::chrono::steady_clock::now() - start;
+		double ns = std::chrono::duration<double, std::nano>(time).count() / Repeats;
+		if (ns < best) best = ns;
+	}
+
+	return best;
+}
+
+template <typename RtFun, typename CtFun, typename StdFun>
+static bool bench(const char *name, const RtFun &rt_fun, const CtFun &ct_fun, const StdFun &std_fun)
+{
+	char rt_text[256] = {};
+	char ct_text[256] = {};
+	rt_fun(rt_text, 0);
+	ct_fun(ct_text, 0);
+
+	bool ok = strcmp(rt_text, ct_text) == 0;
+	if (!ok)
+		::printf("%s: texts differ\n  runtime:      \"%s\"\n  compile-time: \"%s\"\n", name, rt_text, ct_text);
+
+	char buffer[256];
+	double rt_ns = measure_ns([&](unsigned i) { rt_fun(buffer, i); });
+	double ct_ns = measure_ns([&](unsigned i) { ct_fun(buffer, i); });
+	double std_ns = measure_ns([&](unsigned i) { std_fun(buffer, i); });
+
+	::printf("%-14s %10.1f %10.1f %7.2fx %10.1f   %s\n", name, rt_ns, ct_ns, rt_ns / ct_ns, std_ns, ok ? "OK" : "FAILED");
+
+	return ok;
+}
+
+static bool char_callback(void* data, char character)
+{
+	auto* pos = (char**)data;
+	*(*pos)++ = character;
+	return true;
+}
+
+static size_t text_callback(void* data, const char* text, size_t len)
+{
+	auto* pos = (char**)data;
+	memcpy(*pos, text, len);
+	*pos += len;
+	return len;
+}
+
+template <typename Fun>
+static bool bench_sink(const char *name, const Fun &fun)
+{
+	char char_text[256] = {};
+	char text_text[256] = {};
+	char* pos = char_text;
+	fun(char_callback, &pos, 0);
+	pos = text_text;
+	fun(text_callback, &pos, 0);
+
+	bool ok = strcmp(char_text, text_text) == 0;
+	if (!ok)
+		::printf("%s: texts differ\n  by char: \"%s\"\n  by text: \"%s\"\n", name, char_text, text_text);
+
+	char buffer[256];
+	double char_ns = measure_ns([&](unsigned i) { char* p = buffer; fun(char_callback, &p, i); });
+	double text_ns = measure_ns([&](unsigned i) { char* p = buffer; fun(text_callback, &p, i); });
+
+	::printf("%-14s %10.1f %10.1f %7.2fx   %s\n", name, char_ns, text_ns, char_ns / text_ns, ok ? "OK" : "FAILED");
+
+	return ok;
+}
+
+int main()
+{
+	::printf("Time of one call, ns\n\n");
+	::printf("%-14s %10s %10s %8s %10s\n", "format", "runtime", "MF_FMT", "speedup", "snprintf");
+
+	bool ok = true;
+
+	ok &= bench("text only",
+		[](char *buf, unsigned) { mf::format(buf, 256, "Hardware initialized\n"); },
+		[](char *buf, unsigned) { mf::format(buf, 256, MF_FMT("Hardware initialized\n")); },
+		[](char *buf, unsigned) { snprintf(buf, 256, "Hardware initialized\n"); }
+	);
+
+	ok &= bench("integers",
+		[](char *buf, unsigned i) { mf::format(buf, 256, "value_for_srand={} (0x{:x})\n", i, i); },
+		[](char *buf, unsigned i) { mf::format(buf, 256, MF_FMT("value_for_srand={} (0x{:x})\n"), i, i); },
+		[](char *buf, unsigned i) { snprintf(buf, 256, "value_for_srand=%u (0x%x)\n", i, i); }
+	);
+
+	ok &= bench("padded ints",
+		[](char *buf, unsigned i) { mf::format(buf, 256, "  {:<18} count = {:<8} max = {:<8}\n", "motion_update", i, i * 7); },
+		[](char *buf, unsigned i) { mf::format(buf, 256, MF_FMT("  {:<18} count = {:<8} max = {:<8}\n"), "motion_update", i, i * 7); },
+		[](char *buf, unsigned i) { snprintf(buf, 256, "  %-18s count = %-8u max = %-8u\n", "motion_update", i, i * 7); }
+	);
+
+	ok &= bench("time",
+		[](char *buf, unsigned i) { mf::format(buf, 256, ": {}:{:02}", i / 60U, i % 60U); },
+		[](char *buf, unsigned i) { mf::format(buf, 256, MF_FMT(": {}:{:02}"), i / 60U, i % 60U); },
+		[](char *buf, unsigned i) { snprintf(buf, 256, ": %u:%02u", i / 60U, i % 60U); }
+	);
+
+	ok &= bench("tracking line",
+		[](char *buf, unsigned i)
+		{
+			double angle = 19.01 + i * 1e-5;
+			mf::format(buf, 256, "angle = {:.5}, rot_per_secs = {:.5} angle_diff = {:+.5} loop_max = {}\n", angle, 0.01203, -0.00003, i);
+		},
+		[](char *buf, unsigned i)
+		{
+			double angle = 19.01 + i * 1e-5;
+			mf::format(buf, 256, MF_FMT("angle = {:.5}, rot_per_secs = {:.5} angle_diff = {:+.5} loop_max = {}\n"), angle, 0.01203, -0.00003, i);
+		},
+		[](char *buf, unsigned i)
+		{
+			double angle = 19.01 + i * 1e-5;
+			snprintf(buf, 256, "angle = %.5f, rot_per_secs = %.5f angle_diff = %+.5f loop_max = %u\n", angle, 0.01203, -0.00003, i);
+		}
+	);
+
+	::printf("\n%-14s %10s %10s %8s\n", "sink", "by char", "by text", "speedup");
+
+	ok &= bench_sink("text only",
+		[](auto cb, char** pos, unsigned) { mf::format(cb, pos, "Hardware initialized\n"); }
+	);
+
+	ok &= bench_sink("integers",
+		[](auto cb, char** pos, unsigned i) { mf::format(cb, pos, "value_for_srand={} (0x{:x})\n", i, i); }
+	);
+
+	ok &= bench_sink("padded ints",
+		[](auto cb, char** pos, unsigned i) { mf::format(cb, pos, MF_FMT("  {:<18} count = {:<8} max = {:<8}\n"), "motion_update", i, i * 7); }
+	);
+
+	ok &= bench_sink("tracking line",
+		[](auto cb, char** pos, unsigned i)
+		{
+			double angle = 19.01 + i * 1e-5;
+			mf::format(cb, pos, MF_FMT("angle = {:.5}, rot_per_secs = {:.5} angle_diff = {:+.5} loop_max = {}\n"), angle, 0.01203, -0.00003, i);
+		}
+	);
+
+	return ok ? 0 : 1;
+}
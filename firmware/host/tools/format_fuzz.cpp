@@ -0,0 +1,605 @@
+/* Differential check and benchmark of micro_format.
+
+   Random format strings (widths, precisions, alignment, signs, '#', '0',
+   presentation types, manual and automatic indexes) with random arguments
+   of all supported types are printed by mf::format() and by fmt library,
+   results must be the same. UTF-8 decoding of format_u8() is checked
+   against simple reference decoder on random valid and broken sequences.
+   At the end throughput (formats per second) is printed for each argument
+   type. Returns non-zero if any mismatch is found.
+
+   Usage: format_fuzz [iterations] [seed]
+   Comparison with fmt is skipped if its headers are not installed */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <string>
+#include <chrono>
+
+#if __has_include(<fmt/format.h>)
+	#define FMT_HEADER_ONLY
+	#include <fmt/format.h>
+	#include <fmt/args.h>
+	#define HAS_FMT 1
+#else
+	#define HAS_FMT 0
+#endif
+
+#include "mgfxpp/micro_format.hpp"
+
+using mf::impl::FormatArg;
+using mf::impl::FormatArgType;
+
+constexpr unsigned DefaultIterations = 200'000;
+constexpr unsigned MaxArgs = 3;
+constexpr unsigned MaxPrintedErrors = 20;
+
+static unsigned random(unsigned count)
+{
+	return (unsigned)rand() % count;
+}
+
+static bool random_bool(unsigned percent = 50)
+{
+	return random(100) < percent;
+}
+
+/* Argument of random type. Storage is kept here because mf::impl::FormatArg
+   points to the value */
+
+enum class ArgKind
+{
+	Int, UInt, Long, ULong, Char, Bool, Str, Double, Float, Pointer, Count
+};
+
+static const char* const arg_kind_names[] = {
+	"int", "unsigned", "long", "unsigned long", "char", "bool", "const char*", "double", "float", "pointer"
+};
+
+static const char* const random_strings[] = {
+	"", "a", "motion_update", "Hello world", "{}", "x y z"
+};
+
+struct Arg
+{
+	ArgKind kind;
+	int i;
+	unsigned u;
+	long l;
+	unsigned long ul;
+	char c;
+	bool b;
+	const char* s;
+	double d;
+	float f;
+	const void* p;
+
+	FormatArg to_mf() const
+	{
+		switch (kind)
+		{
+		case ArgKind::Int:     return FormatArg(i);
+		case ArgKind::UInt:    return FormatArg(u);
+		case ArgKind::Long:    return FormatArg(l);
+		case ArgKind::ULong:   return FormatArg(ul);
+		case ArgKind::Char:    return FormatArg(c);
+		case ArgKind::Bool:    return FormatArg(b);
+		case ArgKind::Str:     return FormatArg(s);
+		case ArgKind::Double:  return FormatArg(d);
+		case ArgKind::Float:   return FormatArg(f);
+		case ArgKind::Pointer: return FormatArg(p);
+		default: break;
+		}
+		return FormatArg();
+	}
+};
+
+static long random_integer(long min, long max)
+{
+	switch (random(6))
+	{
+	case 0: return min;
+	case 1: return max;
+	case 2: return 0;
+	default:
+		{
+			// random bit length to get both small and big values
+			unsigned long value = ((unsigned long)rand() << 31) ^ rand();
+			value >>= random(sizeof(long) * 8);
+			long result = (long)value;
+			if ((min < 0) && random_bool()) result = -result;
+			if (result < min) result = min;
+			if (result > max) result = max;
+			return result;
+		}
+	}
+}
+
+static double random_double()
+{
+	switch (random(20))
+	{
+	case 0: return 0.0;
+	case 1: return -0.0;
+	case 2: return NAN;
+	case 3: return INFINITY;
+	case 4: return -INFINITY;
+	case 5: return (double)(random(2000) - 1000) / 8; // exact binary values
+	default:
+		{
+			double mantissa = (double)rand() / RAND_MAX;
+			double value = mantissa * pow(10.0, (int)random(16) - 7);
+			return random_bool() ? -value : value;
+		}
+	}
+}
+
+static Arg random_arg()
+{
+	Arg arg {};
+	arg.kind = (ArgKind)random((unsigned)ArgKind::Count);
+
+	arg.i = (int)random_integer(INT_MIN, INT_MAX);
+	arg.u = (unsigned)random_integer(0, UINT_MAX);
+	arg.l = random_integer(LONG_MIN, LONG_MAX);
+	arg.ul = (unsigned long)random_integer(0, LONG_MAX) * (random_bool() ? 2 : 1);
+	arg.c = (char)(' ' + random(95));
+	arg.b = random_bool();
+	arg.s = random_strings[random(sizeof(random_strings) / sizeof(random_strings[0]))];
+	arg.d = random_double();
+	arg.f = (float)random_double();
+	arg.p = (const void*)(uintptr_t)random_integer(0, LONG_MAX);
+
+	return arg;
+}
+
+/* Format specifier for argument. mf_spec is given to micro_format,
+   ref_spec is the same format in fmt syntax. They differ only where
+   micro_format has documented defaults or fmt 9 has known quirks:
+   - floats are printed with precision 6 if it is not set;
+   - pointers are printed as zero-padded hex number with 0x prefix;
+   - fmt 9 aligns nan and inf to the left by default;
+   - fmt 9 and std::format treat zero flag with explicit alignment
+     differently, such specifiers are not generated */
+
+struct Spec
+{
+	std::string mf_spec;
+	std::string ref_spec;
+};
+
+static bool is_align_char(char chr)
+{
+	return (chr == '<') || (chr == '>') || (chr == '^');
+}
+
+static Spec random_spec(const Arg& arg)
+{
+	const ArgKind kind = arg.kind;
+
+	const bool is_int =
+		(kind == ArgKind::Int) || (kind == ArgKind::UInt) ||
+		(kind == ArgKind::Long) || (kind == ArgKind::ULong);
+	const bool is_float = (kind == ArgKind::Double) || (kind == ArgKind::Float);
+
+	// presentation type
+	char type = 0;
+	switch (kind)
+	{
+	case ArgKind::Int: case ArgKind::UInt: case ArgKind::Long: case ArgKind::ULong:
+		type = "\0dxXbBo"[random(7)];
+		break;
+	case ArgKind::Char:
+		type = "\0cdxX"[random(5)];
+		break;
+	case ArgKind::Bool:
+		type = "\0sdx"[random(4)];
+		break;
+	case ArgKind::Str:
+		type = "\0s"[random(2)];
+		break;
+	case ArgKind::Double: case ArgKind::Float:
+		type = "\0fF"[random(3)];
+		break;
+	default:
+		break;
+	}
+
+	const bool is_numeric = is_float || (is_int && (type != 'c')) ||
+		(((kind == ArgKind::Char) || (kind == ArgKind::Bool)) && type && (type != 'c') && (type != 's'));
+
+	// fmt allows sign only for signed types
+	const bool is_signed = is_float || (kind == ArgKind::Int) || (kind == ArgKind::Long);
+
+	Spec spec;
+	std::string common;
+
+	if (kind == ArgKind::Pointer)
+	{
+		spec.mf_spec = "";
+		spec.ref_spec = "#018x";
+		return spec;
+	}
+
+	if (random_bool(40)) common += "<>^"[random(3)];
+	if (is_signed && random_bool(30)) common += "+- "[random(3)];
+	if (is_numeric && !is_float && (type == 'x' || type == 'X' || type == 'b' || type == 'B' || type == 'o') && random_bool(40))
+		common += '#';
+	const bool has_align = !common.empty() && is_align_char(common[0]);
+	if (is_numeric && !has_align && random_bool(30)) common += '0';
+	if (random_bool(60)) common += std::to_string(1 + random(20));
+
+	spec.mf_spec = common;
+	spec.ref_spec = common;
+
+	if (is_float)
+	{
+		double value = (kind == ArgKind::Double) ? arg.d : arg.f;
+		if (!isfinite(value) && !has_align)
+			spec.ref_spec = ">" + common;
+
+		bool has_precision = random_bool(70);
+		int precision = has_precision ? (int)random(9) : 6;
+		if (has_precision)
+			spec.mf_spec += "." + std::to_string(precision);
+		if (type)
+			spec.mf_spec += type;
+		spec.ref_spec += "." + std::to_string(precision) + (type ? type : 'f');
+	}
+	else if (type)
+	{
+		spec.mf_spec += type;
+		spec.ref_spec += type;
+	}
+
+	return spec;
+}
+
+/* Random format string with 1..MaxArgs arguments and literal text between
+   them. Literal text contains escaped braces and UTF-8 characters */
+
+static const char* const random_texts[] = {
+	"", " ", "value = ", "{{", "angle: ", "\xC2\xB0", ", ", "\xD0\xBF\xD1\x80\xD0\xB8", "\n"
+};
+
+struct Case
+{
+	std::string mf_format;
+	std::string ref_format;
+	Arg args[MaxArgs];
+	unsigned args_count;
+};
+
+static void add_text(Case& c)
+{
+	const char* text = random_texts[random(sizeof(random_texts) / sizeof(random_texts[0]))];
+	c.mf_format += text;
+	c.ref_format += text;
+}
+
+static Case random_case()
+{
+	Case c {};
+	c.args_count = 1 + random(MaxArgs);
+	for (unsigned i = 0; i < c.args_count; i++)
+		c.args[i] = random_arg();
+
+	// indexes can't be mixed: all are automatic or all are manual
+	bool manual_index = random_bool(20);
+	unsigned fields_count = manual_index ? 1 + random(MaxArgs + 1) : c.args_count;
+
+	add_text(c);
+	for (unsigned i = 0; i < fields_count; i++)
+	{
+		unsigned index = manual_index ? random(c.args_count) : i;
+		Spec spec = random_spec(c.args[index]);
+		std::string index_text = manual_index ? std::to_string(index) : "";
+
+		c.mf_format += "{" + index_text + (spec.mf_spec.empty() ? "" : ":" + spec.mf_spec) + "}";
+		c.ref_format += "{" + index_text + (spec.ref_spec.empty() ? "" : ":" + spec.ref_spec) + "}";
+
+		add_text(c);
+	}
+
+	return c;
+}
+
+static std::string format_mf(const Case& c)
+{
+	char buffer[512];
+	FormatArg args[MaxArgs];
+	for (unsigned i = 0; i < c.args_count; i++)
+		args[i] = c.args[i].to_mf();
+
+	mf::impl::FormatBufData data = { buffer, sizeof(buffer) - 1 };
+	mf::impl::FormatCtx ctx{ { nullptr, &data, 0, mf::impl::format_buf_text_callback }, args, (int)c.args_count };
+	mf::impl::format_impl(ctx, c.mf_format.c_str());
+	buffer[ctx.dst.chars_printed] = 0;
+
+	return buffer;
+}
+
+#if HAS_FMT
+
+static std::string format_ref(const Case& c)
+{
+	fmt::dynamic_format_arg_store<fmt::format_context> store;
+	for (unsigned i = 0; i < c.args_count; i++)
+	{
+		const Arg& arg = c.args[i];
+		switch (arg.kind)
+		{
+		case ArgKind::Int:     store.push_back(arg.i); break;
+		case ArgKind::UInt:    store.push_back(arg.u); break;
+		case ArgKind::Long:    store.push_back(arg.l); break;
+		case ArgKind::ULong:   store.push_back(arg.ul); break;
+		case ArgKind::Char:    store.push_back(arg.c); break;
+		case ArgKind::Bool:    store.push_back(arg.b); break;
+		case ArgKind::Str:     store.push_back(arg.s); break;
+		case ArgKind::Double:  store.push_back(arg.d); break;
+		case ArgKind::Float:   store.push_back(arg.f); break;
+		case ArgKind::Pointer: store.push_back((uintptr_t)arg.p); break;
+		default: break;
+		}
+	}
+
+	return fmt::vformat(c.ref_format, store);
+}
+
+static std::string describe_args(const Case& c)
+{
+	std::string result;
+	for (unsigned i = 0; i < c.args_count; i++)
+	{
+		const Arg& arg = c.args[i];
+		if (i) result += ", ";
+		result += arg_kind_names[(unsigned)arg.kind];
+		result += " ";
+		switch (arg.kind)
+		{
+		case ArgKind::Int:     result += fmt::format("{}", arg.i); break;
+		case ArgKind::UInt:    result += fmt::format("{}", arg.u); break;
+		case ArgKind::Long:    result += fmt::format("{}", arg.l); break;
+		case ArgKind::ULong:   result += fmt::format("{}", arg.ul); break;
+		case ArgKind::Char:    result += fmt::format("'{}'", arg.c); break;
+		case ArgKind::Bool:    result += fmt::format("{}", arg.b); break;
+		case ArgKind::Str:     result += fmt::format("\"{}\"", arg.s); break;
+		case ArgKind::Double:  result += fmt::format("{}", arg.d); break;
+		case ArgKind::Float:   result += fmt::format("{}", arg.f); break;
+		case ArgKind::Pointer: result += fmt::format("{}", arg.p); break;
+		default: break;
+		}
+	}
+	return result;
+}
+
+static unsigned check_format(unsigned iterations)
+{
+	unsigned errors = 0;
+
+	for (unsigned i = 0; i < iterations; i++)
+	{
+		Case c = random_case();
+		std::string result = format_mf(c);
+		std::string expected = format_ref(c);
+
+		if (result == expected) continue;
+
+		if (errors < MaxPrintedErrors)
+		{
+			::printf("  MISMATCH \"%s\" (%s)\n", c.mf_format.c_str(), describe_args(c).c_str());
+			::printf("    fmt:          \"%s\"\n", expected.c_str());
+			::printf("    micro_format: \"%s\"\n", result.c_str());
+		}
+		errors++;
+	}
+
+	return errors;
+}
+
+#endif
+
+/* UTF-8: random sequence of valid characters of 1..4 bytes, lone
+   continuation bytes, invalid lead bytes and truncated characters.
+   Reference decoder replaces every broken sequence with '?' and
+   starts again from the byte which broke it */
+
+static void append_utf8(std::string& text, mf::WideChar chr)
+{
+	if (chr < 0x80)
+		text += (char)chr;
+	else if (chr < 0x800)
+	{
+		text += (char)(0xC0 | (chr >> 6));
+		text += (char)(0x80 | (chr & 0x3F));
+	}
+	else if (chr < 0x10000)
+	{
+		text += (char)(0xE0 | (chr >> 12));
+		text += (char)(0x80 | ((chr >> 6) & 0x3F));
+		text += (char)(0x80 | (chr & 0x3F));
+	}
+	else
+	{
+		text += (char)(0xF0 | (chr >> 18));
+		text += (char)(0x80 | ((chr >> 12) & 0x3F));
+		text += (char)(0x80 | ((chr >> 6) & 0x3F));
+		text += (char)(0x80 | (chr & 0x3F));
+	}
+}
+
+static std::string random_utf8_text()
+{
+	std::string text;
+	unsigned count = random(12);
+	for (unsigned i = 0; i < count; i++)
+	{
+		switch (random(8))
+		{
+		case 0: text += (char)(0x80 | random(0x40)); break;   // lone continuation
+		case 1: text += (char)(0xF8 | random(8)); break;      // invalid lead
+		case 2:                                                // truncated
+			{
+				std::string chr;
+				append_utf8(chr, 0x80 + random(0x10FF80));
+				text += chr.substr(0, 1 + random(chr.size() - 1));
+				break;
+			}
+		case 3: append_utf8(text, 0x80 + random(0x780)); break;
+		case 4: append_utf8(text, 0x800 + random(0xF800)); break;
+		case 5: append_utf8(text, 0x10000 + random(0x100000)); break;
+		default: append_utf8(text, ' ' + random(95)); break;
+		}
+	}
+	return text;
+}
+
+static std::u32string reference_utf8_decode(const std::string& text)
+{
+	std::u32string result;
+	size_t pos = 0;
+
+	while (pos < text.size())
+	{
+		unsigned char lead = text[pos];
+		unsigned count = 0;
+		mf::WideChar chr = 0;
+
+		if ((lead & 0x80) == 0x00) { result += lead; pos++; continue; }
+		else if ((lead & 0xE0) == 0xC0) { count = 1; chr = lead & 0x1F; }
+		else if ((lead & 0xF0) == 0xE0) { count = 2; chr = lead & 0x0F; }
+		else if ((lead & 0xF8) == 0xF0) { count = 3; chr = lead & 0x07; }
+		else { result += '?'; pos++; continue; }
+
+		pos++;
+		unsigned i = 0;
+		for (; (i < count) && (pos < text.size()); i++, pos++)
+		{
+			unsigned char next = text[pos];
+			if ((next & 0xC0) != 0x80) break;
+			chr = (chr << 6) | (next & 0x3F);
+		}
+
+		if (i == count)
+			result += chr;
+		else if (pos < text.size())
+			result += '?'; // broken by non-continuation byte, it is decoded again
+		// character truncated by end of text is not printed
+	}
+
+	return result;
+}
+
+static unsigned check_utf8(unsigned iterations)
+{
+	unsigned errors = 0;
+
+	auto wide_callback = [](void* data, mf::WideChar chr)
+	{
+		*(std::u32string*)data += chr;
+		return true;
+	};
+
+	for (unsigned i = 0; i < iterations; i++)
+	{
+		std::string text = random_utf8_text();
+		std::u32string result;
+		mf::format_u8(wide_callback, &result, "{}", text.c_str());
+		std::u32string expected = reference_utf8_decode(text);
+
+		if (result == expected) continue;
+
+		if (errors < MaxPrintedErrors)
+		{
+			::printf("  MISMATCH utf8 bytes:");
+			for (unsigned char chr : text) ::printf(" %02X", chr);
+			::printf("\n    expected:");
+			for (auto chr : expected) ::printf(" %X", (unsigned)chr);
+			::printf("\n    decoded: ");
+			for (auto chr : result) ::printf(" %X", (unsigned)chr);
+			::printf("\n");
+		}
+		errors++;
+	}
+
+	return errors;
+}
+
+/* Throughput for each argument type with typical specifier */
+
+template <typename Fun>
+static double measure_per_second(const Fun &fun)
+{
+	constexpr unsigned count = 100'000;
+	double best = 0;
+
+	for (unsigned pass = 0; pass < 5; pass++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < count; i++)
+		{
+			fun(i);
+			asm volatile("" : : : "memory");
+		}
+		auto time = std::chrono::steady_clock::now() - start;
+		double per_second = count / std::chrono::duration<double>(time).count();
+		if (per_second > best) best = per_second;
+	}
+
+	return best;
+}
+
+template <typename T>
+static void bench_type(const char* name, const char* format, const T& value)
+{
+	char buffer[128];
+	double mf_rate = measure_per_second([&](unsigned) { mf::format(buffer, format, value); });
+#if HAS_FMT
+	double fmt_rate = measure_per_second([&](unsigned) { fmt::format_to_n(buffer, sizeof(buffer), fmt::runtime(format), value); });
+	::printf("%-14s %-10s %12.2f %12.2f\n", name, format, mf_rate / 1e6, fmt_rate / 1e6);
+#else
+	::printf("%-14s %-10s %12.2f\n", name, format, mf_rate / 1e6);
+#endif
+}
+
+static void bench()
+{
+	::printf("\nThroughput, millions of formats per second\n\n");
+	::printf("%-14s %-10s %12s %12s\n", "type", "format", "micro_format", HAS_FMT ? "fmt" : "");
+
+	bench_type("int", "{}", -1234567);
+	bench_type("unsigned", "{:08x}", 0xBEEFu);
+	bench_type("long", "{:>12}", 123456789L);
+	bench_type("char", "{}", 'A');
+	bench_type("bool", "{}", true);
+	bench_type("const char*", "{:<18}", "motion_update");
+	bench_type("double", "{:.5f}", 19.01444);
+	bench_type("float", "{:+.2f}", -0.25f);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned iterations = (argc > 1) ? (unsigned)atoi(argv[1]) : DefaultIterations;
+	unsigned seed = (argc > 2) ? (unsigned)atoi(argv[2]) : 1;
+	srand(seed);
+
+	unsigned format_errors = 0;
+#if HAS_FMT
+	::printf("Formatting, %u random format strings compared with fmt %d:\n", iterations, FMT_VERSION);
+	format_errors = check_format(iterations);
+	::printf("  mismatches: %u\n", format_errors);
+#else
+	::printf("Formatting: fmt headers not found, comparison skipped\n");
+#endif
+
+	::printf("UTF-8 decoding, %u random texts:\n", iterations);
+	unsigned utf8_errors = check_utf8(iterations);
+	::printf("  mismatches: %u\n", utf8_errors);
+
+	bench();
+
+	return (format_errors || utf8_errors) ? 1 : 0;
+}
@@ -0,0 +1,320 @@
+/* Rendering benchmark for mgfxpp primitives.
+
+   Mono build (default host build) draws into MonoBufferedDisplay with
+   counting in-memory controller. Color build (gfx_bench_color, built
+   with MGFXPP_COLOR) draws into InMemoryDisplay565 which has no rotation.
+
+   Every primitive is measured for all rotations and for three clip
+   cases: inside of display, crossing its corner and outside of it.
+   Reports ns per call, pixels drawn per call and pixels per second.
+   With --csv argument prints CSV for comparison between builds */
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include "mgfxpp_display.hpp"
+#include "mgfxpp_draw.hpp"
+#include "fonts/font_roboto_bold11_en.hpp"
+
+using namespace mgfxpp;
+
+constexpr double MinMeasureTimeNs = 20e6;
+constexpr unsigned MeasurePasses = 3;
+
+#if defined(MGFXPP_MONO)
+
+static const char BuildName[] = "mono";
+
+// display controller keeping its memory to count drawn pixels
+struct BenchDisplay
+{
+	static constexpr unsigned Width = 128;
+	static constexpr unsigned Height = 64;
+
+	static constexpr unsigned get_width() { return Width; }
+	static constexpr unsigned get_height() { return Height; }
+
+	static void set_pos(unsigned col, unsigned row)
+	{
+		col_ = col;
+		row_ = row;
+	}
+
+	static void write_data(uint8_t data)
+	{
+		if ((row_ < Height / 8) && (col_ < Width))
+			ram_[row_][col_] = data;
+		col_++;
+	}
+
+	static void flush() {}
+
+	static unsigned count_pixels()
+	{
+		unsigned result = 0;
+		for (auto &row : ram_)
+			for (auto value : row)
+				result += __builtin_popcount(value);
+		return result;
+	}
+
+private:
+	inline static uint8_t ram_[Height / 8][Width] = {};
+	inline static unsigned col_ = 0;
+	inline static unsigned row_ = 0;
+};
+
+using BenchBuffer = MonoBufferedDisplay<BenchDisplay>;
+
+MGFXPP_DISPLAY_BUFFERED_IMPL(BenchBuffer)
+
+static const Color PixelOnColor = Color::PixelOn;
+static const Color PixelOffColor = Color::PixelOff;
+
+static const DisplayRotation rotations[] = {
+	DisplayRotation::NS,
+	DisplayRotation::WE,
+	DisplayRotation::SN,
+	DisplayRotation::EW
+};
+
+static void init_display() {}
+
+static void set_rotation(DisplayRotation rotation)
+{
+	BenchBuffer::set_rotation(rotation);
+
+	// clip rect is updated by draw
+	display_draw([] {});
+}
+
+static void clear_display()
+{
+	display_draw([] { display_fill_rect(display_get_clip_rect(), Color::PixelOff); });
+}
+
+template <typename Fun>
+static unsigned count_pixels(const Fun &fun)
+{
+	clear_display();
+	display_draw(fun);
+	return BenchDisplay::count_pixels();
+}
+
+#elif defined(MGFXPP_COLOR)
+
+static const char BuildName[] = "color";
+
+constexpr unsigned Width = 320;
+constexpr unsigned Height = 240;
+
+static uint16_t memory[Width * Height];
+static InMemoryDisplay565<Width, Height> bench_display;
+static const DisplayRect clip_rect { 0, 0, Width - 1, Height - 1 };
+
+namespace mgfxpp {
+
+DispCrd display_get_width() { return Width; }
+DispCrd display_get_height() { return Height; }
+const DisplayRect& display_get_clip_rect() { return clip_rect; }
+void display_set_pixel(DispCrd x, DispCrd y, Color color) { bench_display.set_pixel(x, y, color); }
+void display_fill_rect(const DisplayRect &rect, Color color) { bench_display.fill_rect(rect, color); }
+void display_draw(DrawFun fun, const void *data) { fun(data); }
+bool display_draw_glyph(DispCrd, DispCrd, const DisplayGlyph&, Color, Color) { return false; }
+bool display_has_draw_glyph() { return false; }
+
+} // namespace mgfxpp
+
+static const Color PixelOnColor = White;
+static const Color PixelOffColor = Black;
+
+static const DisplayRotation rotations[] = { DisplayRotation::NS };
+
+static void init_display()
+{
+	bench_display.set_memory_address(memory);
+}
+
+static void set_rotation(DisplayRotation) {}
+
+template <typename Fun>
+static unsigned count_pixels(const Fun &fun)
+{
+	bench_display.clear();
+	fun();
+	unsigned result = 0;
+	for (auto value : memory)
+		if (value) result++;
+	return result;
+}
+
+#endif
+
+static const char* get_rotation_name(DisplayRotation rotation)
+{
+	switch (rotation)
+	{
+	case DisplayRotation::NS: return "NS";
+	case DisplayRotation::WE: return "WE";
+	case DisplayRotation::SN: return "SN";
+	case DisplayRotation::EW: return "EW";
+	}
+	return "?";
+}
+
+enum class Clip
+{
+	Inside,
+	Partial,
+	Outside
+};
+
+static const Clip clips[] = { Clip::Inside, Clip::Partial, Clip::Outside };
+
+static const char* get_clip_name(Clip clip)
+{
+	switch (clip)
+	{
+	case Clip::Inside: return "inside";
+	case Clip::Partial: return "partial";
+	case Clip::Outside: return "outside";
+	}
+	return "?";
+}
+
+// Bounding rect of figure for clip case: half of display size
+// in the middle, centered at bottom right corner or out of display
+static Rect get_figure_rect(Clip clip)
+{
+	Crd w = display_get_width();
+	Crd h = display_get_height();
+	Crd fw = w / 2;
+	Crd fh = h / 2;
+
+	switch (clip)
+	{
+	case Clip::Inside: return Rect(w / 4, h / 4, w / 4 + fw - 1, h / 4 + fh - 1);
+	case Clip::Partial: return Rect(w - fw / 2, h - fh / 2, w - fw / 2 + fw - 1, h - fh / 2 + fh - 1);
+	case Clip::Outside: return Rect(w + 10, h / 4, w + 10 + fw - 1, h / 4 + fh - 1);
+	}
+
+	return {};
+}
+
+struct Primitive
+{
+	const char *name;
+	bool is_fill; // filled by background color
+	void (*draw)(const Rect &rect);
+};
+
+static const Primitive primitives[] = {
+	{ "fill_rect", true, [] (const Rect &r)
+		{
+			fill_rect(r);
+		}
+	},
+	{ "draw_line", false, [] (const Rect &r)
+		{
+			draw_line(r.left, r.top, r.right, r.bottom);
+		}
+	},
+	{ "fill_ellipse", true, [] (const Rect &r)
+		{
+			fill_ellipse(r);
+		}
+	},
+	{ "fill_triangle", true, [] (const Rect &r)
+		{
+			fill_triangle(r.left, r.bottom, (r.left + r.right) / 2, r.top, r.right, r.bottom);
+		}
+	},
+	{ "print_symbol", false, [] (const Rect &r)
+		{
+			draw_string_at(r.left, r.top, "W");
+		}
+	},
+	{ "draw_string", false, [] (const Rect &r)
+		{
+			draw_string_at(r.left, r.top, "Dither time");
+		}
+	},
+	{ "printf_at", false, [] (const Rect &r)
+		{
+			mgfxpp::printf_at(r.left, r.top, u8": {:.1}°", 12.34);
+		}
+	},
+};
+
+// foreground is drawn by pixel on color, background by pixel off one.
+// Fills use background color so it is set to pixel on for them
+static void set_colors(const Primitive &primitive)
+{
+	set_current_font(font_roboto_bold11_en);
+	set_fg_color(PixelOnColor);
+	set_bg_color(primitive.is_fill ? PixelOnColor : PixelOffColor);
+}
+
+static double measure_ns_per_call(const Primitive &primitive, const Rect &rect)
+{
+	double best = 0;
+
+	for (unsigned pass = 0; pass < MeasurePasses; pass++)
+	{
+		unsigned count = 0;
+		double time_ns = 0;
+		auto start = std::chrono::steady_clock::now();
+		do
+		{
+			for (unsigned i = 0; i < 64; i++)
+				primitive.draw(rect);
+			count += 64;
+			auto time = std::chrono::steady_clock::now() - start;
+			time_ns = std::chrono::duration<double, std::nano>(time).count();
+		}
+		while (time_ns < MinMeasureTimeNs);
+
+		double ns_per_call = time_ns / count;
+		if ((pass == 0) || (ns_per_call < best)) best = ns_per_call;
+	}
+
+	return best;
+}
+
+int main(int argc, char *argv[])
+{
+	const bool csv = (argc > 1) && (strcmp(argv[1], "--csv") == 0);
+
+	init_display();
+
+	if (csv)
+		::printf("build,primitive,rotation,clip,ns_per_call,pixels_per_call,mpixels_per_sec\n");
+	else
+		::printf("%-6s %-14s %-4s %-8s %12s %10s %12s\n", "build", "primitive", "rot", "clip", "ns/call", "pixels", "Mpixels/s");
+
+	for (auto &primitive : primitives)
+	{
+		for (auto rotation : rotations)
+		{
+			set_rotation(rotation);
+
+			for (auto clip : clips)
+			{
+				const Rect rect = get_figure_rect(clip);
+
+				set_colors(primitive);
+				unsigned pixels = count_pixels([&] { primitive.draw(rect); });
+				double ns = measure_ns_per_call(primitive, rect);
+				double mpixels_per_sec = pixels * 1e3 / ns;
+
+				if (csv)
+					::printf("%s,%s,%s,%s,%.1f,%u,%.2f\n", BuildName, primitive.name, get_rotation_name(rotation), get_clip_name(clip), ns, pixels, mpixels_per_sec);
+				else
+					::printf("%-6s %-14s %-4s %-8s %12.1f %10u %12.2f\n", BuildName, primitive.name, get_rotation_name(rotation), get_clip_name(clip), ns, pixels, mpixels_per_sec);
+			}
+		}
+	}
+
+	return 0;
+}
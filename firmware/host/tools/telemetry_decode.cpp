@@ -0,0 +1,86 @@
+/* Converts captured debug UART stream with binary telemetry frames
+   (see src/telemetry.hpp) into CSV. Text messages between frames and
+   broken frames are skipped.
+
+   Usage: telemetry_decode [capture_file] > telemetry.csv
+   Stream is read from stdin if file is not given */
+
+#include <stdio.h>
+
+#include "telemetry.hpp"
+
+static const char* get_state_name(TelemetryState state)
+{
+	switch (state)
+	{
+	case TelemetryState::Idle: return "idle";
+	case TelemetryState::Tracking: return "tracking";
+	case TelemetryState::Dithering: return "dithering";
+	case TelemetryState::Reverting: return "reverting";
+	}
+	return "?";
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *file = stdin;
+	if (argc > 1)
+	{
+		file = fopen(argv[1], "rb");
+		if (!file)
+		{
+			fprintf(stderr, "Can't open %s\n", argv[1]);
+			return 1;
+		}
+	}
+
+	printf("time_ms,steps,commanded_rps,current_rps,angle_error_arcsec,seconds_to_dither,state\n");
+
+	// blocks longer than frame are text messages, they are not stored
+	uint8_t block[TelemetryEncodedMaxSize];
+	unsigned block_size = 0;
+	bool block_overflow = false;
+	unsigned frames_count = 0;
+	unsigned skipped_count = 0;
+
+	for (int chr; (chr = fgetc(file)) != EOF;)
+	{
+		if (chr != 0)
+		{
+			if (block_size < sizeof(block))
+				block[block_size++] = (uint8_t)chr;
+			else
+				block_overflow = true;
+			continue;
+		}
+
+		TelemetryFrame frame;
+		if (!block_overflow && block_size && telemetry_decode(block, block_size, frame))
+		{
+			printf(
+				"%llu,%d,%.6f,%.6f,%.3f,%u,%s\n",
+				(unsigned long long)frame.time_ms,
+				(int)frame.steps,
+				frame.commanded_rps,
+				frame.current_rps,
+				frame.angle_error,
+				(unsigned)frame.seconds_to_dither,
+				get_state_name(frame.state)
+			);
+			frames_count++;
+		}
+		else if (block_size)
+		{
+			skipped_count++;
+		}
+
+		block_size = 0;
+		block_overflow = false;
+	}
+
+	if (file != stdin) fclose(file);
+
+	fprintf(stderr, "frames = %u, skipped blocks = %u\n", frames_count, skipped_count);
+
+	return 0;
+}
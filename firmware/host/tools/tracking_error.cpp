@@ -0,0 +1,107 @@
+/* Error budget of tracking calculations in float against double.
+
+   Sweeps the whole StartL..MaxL range with one motor step and simulates
+   a tracking session from StartL to MaxL with speed recalculated every
+   500 ms. Errors are reported in arc-seconds against double calculations
+   by the original (numeric) method */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "hardware.hpp"
+#include "tracking_math.hpp"
+
+constexpr double ToleranceArcsec = 1.0;
+constexpr double RecalcPeriod = 0.5; // seconds
+constexpr double ArcsecInRad = 180.0 * 3600.0 / Pi;
+
+struct ErrorBudget
+{
+	double angle = 0;       // angle by rod length, arc-seconds
+	double speed = 0;       // rod speed, ppm
+	double ideal_angle = 0; // ideal angle by time, arc-seconds
+	double session = 0;     // tracking drift in session, arc-seconds
+};
+
+static void update_max(double &max, double value)
+{
+	value = fabs(value);
+	if (value > max) max = value;
+}
+
+template <typename T, typename SpeedFun>
+static ErrorBudget calc_error_budget(const SpeedFun &speed_fun)
+{
+	ErrorBudget result;
+
+	constexpr double StepL = RodStep * TurnsOnStep;
+	const int32_t max_steps = (int32_t)((MaxL - StartL) / StepL);
+
+	for (int32_t steps = 0; steps <= max_steps; steps++)
+	{
+		double l = steps * StepL + StartL;
+		T l_t = steps * (T)StepL + (T)StartL;
+
+		update_max(result.angle, ((double)calc_angle(l_t) - calc_angle(l)) * ArcsecInRad);
+
+		double speed = calc_l_speed_numeric(l);
+		update_max(result.speed, 1e6 * ((double)speed_fun(l_t) - speed) / speed);
+	}
+
+	// tracking session: rod speed is passed to motor as float rotations per second
+
+	const double start_angle = calc_angle(StartL);
+	const T start_angle_t = calc_angle((T)StartL);
+	double l_ref = StartL;
+	double l = StartL;
+	for (uint32_t time_ms = 0; l < MaxL; time_ms += (uint32_t)(RecalcPeriod * 1000))
+	{
+		double ideal_angle = start_angle + time_ms / 1000.0 * RotSpeed;
+		T ideal_angle_t = start_angle_t + (T)time_ms / (T)1000 * (T)RotSpeed;
+		update_max(result.ideal_angle, ((double)ideal_angle_t - ideal_angle) * ArcsecInRad);
+
+		update_max(result.session, (calc_angle(l) - calc_angle(l_ref)) * ArcsecInRad);
+
+		float rps_ref = (float)(calc_l_speed_numeric(l_ref) / RodStep);
+		float rps = (float)(speed_fun((T)l) / (T)RodStep);
+		l_ref += rps_ref * RodStep * RecalcPeriod;
+		l += rps * RodStep * RecalcPeriod;
+	}
+
+	return result;
+}
+
+template <typename T, typename SpeedFun>
+static bool print_error_budget(const char* name, const SpeedFun &speed_fun)
+{
+	auto budget = calc_error_budget<T>(speed_fun);
+
+	double max_angle_err = budget.angle + budget.ideal_angle + budget.session;
+	bool ok = max_angle_err < ToleranceArcsec;
+
+	printf(
+		"%-16s %12.5f %12.4f %12.5f %12.5f %12.5f   %s\n",
+		name,
+		budget.angle,
+		budget.speed,
+		budget.ideal_angle,
+		budget.session,
+		max_angle_err,
+		ok ? "OK" : "FAILED"
+	);
+
+	return ok;
+}
+
+int main()
+{
+	printf("Tracking error against double/numeric, tolerance %.2f arc-seconds\n\n", ToleranceArcsec);
+	printf("%-16s %12s %12s %12s %12s %12s\n", "mode", "angle, \"", "speed, ppm", "ideal, \"", "session, \"", "total, \"");
+
+	bool ok = true;
+	ok &= print_error_budget<double>("double/analytic", calc_l_speed_analytic<double>);
+	ok &= print_error_budget<float>("float/numeric", [](float l) { return (float)calc_l_speed_numeric(l); });
+	ok &= print_error_budget<float>("float/analytic", calc_l_speed_analytic<float>);
+
+	return ok ? 0 : 1;
+}
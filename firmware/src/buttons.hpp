@@ -0,0 +1,175 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "config.hpp"
+
+enum class ButtonId : uint8_t
+{
+	Revert,
+	DitherTime,
+	DitherAngle,
+	Count
+};
+
+enum class ButtonAction : uint8_t
+{
+	Press,
+	Release,
+	LongPress, // button is held ButtonLongPressMs
+	Repeat     // each ButtonRepeatMs after long press (if enabled for button)
+};
+
+struct ButtonEvent
+{
+	ButtonId button = ButtonId::Revert;
+	ButtonAction action = ButtonAction::Press;
+};
+
+// buttons sending Repeat events while held (to change dither settings quickly)
+constexpr uint32_t ButtonRepeatMask =
+	(1U << (unsigned)ButtonId::DitherTime) |
+	(1U << (unsigned)ButtonId::DitherAngle);
+
+constexpr unsigned ButtonDebounceMs = 20;
+
+/* Button events engine. Port gives access to inputs:
+
+       static bool is_pressed(unsigned button);  // current level
+       static void enable_edge_irq(unsigned button);  // with pending edge cleared
+       static void disable_edge_irq(unsigned button);
+       static void notify();  // event is put into queue
+
+   Edge interrupt of input calls on_edge(), it is disabled while level
+   is settling, input is read once ButtonDebounceMs after the edge.
+   tick() is called from time timer interrupt, it checks only buttons
+   being debounced or held, so idle buttons cost nothing. Edge and time
+   interrupts must not preempt each other. Events are taken by main loop
+   only (single producer, single consumer queue) */
+
+template <typename Port, unsigned TickFreq>
+class ButtonEngine
+{
+public:
+	static constexpr unsigned Count = (unsigned)ButtonId::Count;
+
+	void on_edge(unsigned button, unsigned time_counter)
+	{
+		Port::disable_edge_irq(button);
+
+		auto &state = states_[button];
+		state.debounce_end = time_counter + DebounceTicks;
+		state.debouncing = true;
+		active_ = active_ | (1U << button);
+	}
+
+	void tick(unsigned time_counter)
+	{
+		for (uint32_t mask = active_; mask; mask &= mask - 1)
+			update(__builtin_ctz(mask), time_counter);
+	}
+
+	bool is_pressed(unsigned button) const
+	{
+		return states_[button].pressed;
+	}
+
+	bool get_event(ButtonEvent &event)
+	{
+		unsigned rd_pos = rd_pos_;
+		if (rd_pos == wr_pos_) return false;
+		event = { (ButtonId)events_[rd_pos].button, (ButtonAction)events_[rd_pos].action };
+		rd_pos_ = (rd_pos + 1) % QueueSize;
+		return true;
+	}
+
+	uint32_t get_dropped_count() const
+	{
+		return dropped_;
+	}
+
+private:
+	static constexpr unsigned DebounceTicks = ButtonDebounceMs * TickFreq / 1000;
+	static constexpr unsigned LongPressTicks = ButtonLongPressMs * TickFreq / 1000;
+	static constexpr unsigned RepeatTicks = ButtonRepeatMs * TickFreq / 1000;
+	static constexpr unsigned QueueSize = 16;
+
+	struct State
+	{
+		volatile bool pressed = false; // read by main loop
+		bool debouncing = false;
+		bool holding = false;      // long press or repeat is waited
+		bool long_pressed = false;
+		unsigned debounce_end = 0;
+		unsigned hold_end = 0;
+	};
+
+	struct QueueItem
+	{
+		uint8_t button;
+		uint8_t action;
+	};
+
+	static bool is_expired(unsigned deadline, unsigned time_counter)
+	{
+		return (int32_t)(time_counter - deadline) >= 0;
+	}
+
+	void put_event(unsigned button, ButtonAction action)
+	{
+		unsigned wr_pos = wr_pos_;
+		unsigned next_pos = (wr_pos + 1) % QueueSize;
+		if (next_pos == rd_pos_)
+		{
+			dropped_ = dropped_ + 1;
+			return;
+		}
+
+		events_[wr_pos].button = button;
+		events_[wr_pos].action = (uint8_t)action;
+		wr_pos_ = next_pos;
+
+		Port::notify();
+	}
+
+	void update(unsigned button, unsigned time_counter)
+	{
+		auto &state = states_[button];
+
+		if (state.debouncing && is_expired(state.debounce_end, time_counter))
+		{
+			// edge after input is read makes new debouncing
+			state.debouncing = false;
+			Port::enable_edge_irq(button);
+
+			bool pressed = Port::is_pressed(button);
+			if (pressed != state.pressed)
+			{
+				state.pressed = pressed;
+				state.holding = pressed;
+				state.long_pressed = false;
+				state.hold_end = time_counter + LongPressTicks;
+				put_event(button, pressed ? ButtonAction::Press : ButtonAction::Release);
+			}
+		}
+
+		if (state.holding && is_expired(state.hold_end, time_counter))
+		{
+			put_event(button, state.long_pressed ? ButtonAction::Repeat : ButtonAction::LongPress);
+			state.long_pressed = true;
+			state.holding = (ButtonRepeatMask & (1U << button)) != 0;
+			state.hold_end += RepeatTicks;
+		}
+
+		if (!state.debouncing && !state.holding)
+			active_ = active_ & ~(1U << button);
+	}
+
+	State states_[Count] = {};
+	volatile uint32_t active_ = 0; // buttons being debounced or held
+
+	volatile QueueItem events_[QueueSize] = {};
+	volatile unsigned wr_pos_ = 0;
+	volatile unsigned rd_pos_ = 0;
+	volatile uint32_t dropped_ = 0;
+};
@@ -36,3 +36,49 @@ constexpr double MoveMaxAngle = 0.3;
 
 // Maximum dither period in minutes
 constexpr int32_t MovePeriod = 10;
+
+// Maximum rod speed of dither move in rotations per second. Move is
+// accelerated and decelerated by MaxStepMotorAccel
+constexpr double MoveSpeed = 1.0;
+
+
+/******* buttons *******/
+
+// Held button sends long press event after ButtonLongPressMs. Dither
+// buttons are repeated then each ButtonRepeatMs (see buttons.hpp)
+constexpr unsigned ButtonLongPressMs = 800;
+constexpr unsigned ButtonRepeatMs = 250;
+
+
+/******* tracking math *******/
+
+// Method to calculate rod speed from rod length
+enum class RodSpeedMethod
+{
+	Numeric,  // numeric differentiation of length by angle
+	Analytic  // dl/da = R*cos(a/2) expressed through rod length
+};
+
+constexpr RodSpeedMethod RodSpeedCalc = RodSpeedMethod::Analytic;
+
+// Floating point type for tracking calculations. MCU has no FPU, so float
+// is several times cheaper than double. Error of float against double is
+// reported by host/tools/tracking_error (make host)
+using TrackingFloat = double;
+
+
+/******* diagnostics *******/
+
+// Measure time of ISRs and main loop stages (see profiling.hpp).
+// Statistics are printed to debug UART every ProfDumpPeriod seconds.
+// Off in production firmware, on in host build (see PROFILING in makefile)
+#if defined(PROFILING_ENABLED)
+constexpr bool ProfilingEnabled = true;
+#else
+constexpr bool ProfilingEnabled = false;
+#endif
+constexpr unsigned ProfDumpPeriod = 60;
+
+// Period of binary telemetry frames in ms (see telemetry.hpp), 0 to disable.
+// When enabled, periodical text tracking line is not printed
+constexpr unsigned TelemetryPeriodMs = 0;
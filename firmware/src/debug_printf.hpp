@@ -7,13 +7,21 @@
 
 /* debug_printf ans UART stuff */
 
+// text is passed to UART buffer by whole runs, not by characters
+inline size_t debug_uart_text_callback(void*, const char* text, size_t len)
+{
+	return send_debug_uart_text(text, len);
+}
+
 template <typename ... Args>
 size_t debug_printf(const char* format, const Args& ... args)
 {
-	auto uart_format_callback = [](auto, char character)
-	{
-		send_debug_uart_char(character);
-		return true;
-	};
-	return mf::format(uart_format_callback, nullptr, format, args...);
+	return mf::format(debug_uart_text_callback, nullptr, format, args...);
+}
+
+// debug_printf with format string parsed at compile time: debug_printf(MF_FMT("..."), ...)
+template <typename Str, typename ... Args>
+size_t debug_printf(mf::FormatString<Str> format, const Args& ... args)
+{
+	return mf::format(debug_uart_text_callback, nullptr, format, args...);
 }
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Events posted by interrupts to main loop. Main loop sleeps until
+   event is posted (see wait_event() in hardware.hpp) */
+
+enum class Event : uint8_t
+{
+	None,
+	Timer,         // time set by set_timer_event() is reached
+	Button,        // button event is put (see get_button_event())
+	MoveDone,      // limited step schedule made its last step
+	DisplayReady,  // display data is sent
+	Count
+};
+
+/* Ring buffer of events. Events are put by ISRs and taken by main loop
+   only. ISRs posting events have the same priority and don't preempt
+   each other, so it is single producer, single consumer queue without
+   locks. Event already waiting in queue is not put again, so queue
+   can't overflow while main loop is busy */
+
+class EventQueue
+{
+public:
+	// called from ISR
+	void post(Event event)
+	{
+		if (queued_[(unsigned)event]) return;
+
+		unsigned wr_pos = wr_pos_;
+		items_[wr_pos] = event;
+		queued_[(unsigned)event] = true;
+		wr_pos_ = (wr_pos + 1) % Size;
+	}
+
+	// called from main loop. Returns Event::None if queue is empty
+	Event get()
+	{
+		unsigned rd_pos = rd_pos_;
+		if (rd_pos == wr_pos_) return Event::None;
+
+		// event posted again after this point is handled again
+		Event event = items_[rd_pos];
+		queued_[(unsigned)event] = false;
+		rd_pos_ = (rd_pos + 1) % Size;
+
+		return event;
+	}
+
+private:
+	// one item for each event except None and one free item
+	static constexpr unsigned Size = (unsigned)Event::Count;
+
+	volatile Event items_[Size] = {};
+	volatile bool queued_[Size] = {};
+	volatile unsigned wr_pos_ = 0;
+	volatile unsigned rd_pos_ = 0;
+};
@@ -394,12 +394,20 @@ static const Character chars[] = {
 	{176, bitmaps + 1447},
 };
 
+static const CharRange ranges[] = {
+	// first character code, count, index of first character
+	{32, 95, 0},
+	{176, 1, 95},
+};
+
 const Font font_roboto_bold11_en = {
 	16, // height
-	FONT_FLAG_CHARS_SORTED, // flags
+	FONT_FLAG_CHARS_SORTED | FONT_FLAG_CHARS_RANGES, // flags
 	0, // spacing
 	96, // character count
-	chars // characters data
+	chars, // characters data
+	2, // ranges count
+	ranges // ranges of character codes
 };
 
 } //namespace mgfxpp
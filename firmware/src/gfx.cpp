@@ -1,6 +1,10 @@
+#include <math.h>
+#include <limits.h>
+
 #include "gfx.hpp"
 
 #include "hardware.hpp"
+#include "debug_printf.hpp"
 #include "mgfxpp/mgfxpp_draw.hpp"
 #include "mgfxpp/mgfxpp_display.hpp"
 #include "fonts/font_roboto_bold11_en.hpp"
@@ -18,26 +22,181 @@ void show_wellcome_screen()
 	});
 }
 
-void show_cur_info(double angle, unsigned seconds_to_dithering, double dither_angle)
+/* Info screen is rendered in background: post_cur_info() only stores
+   snapshot of values, process_display() renders and sends one line
+   of it per call. So time taken from main loop is limited by one line.
+   Labels are drawn once, value is redrawn only if its text is changed */
+
+struct InfoSnapshot
 {
-	if (!is_display_ok()) return;
+	double angle;
+	unsigned seconds_to_dithering;
+	double dither_angle;
+};
 
-	mgfxpp::display_draw([&]
+enum InfoLine : unsigned
+{
+	Labels,
+	Angle,
+	DitherTime,
+	DitherAngle,
+	LinesCount
+};
+
+static InfoSnapshot posted_info = {};
+static InfoSnapshot render_info = {};
+static bool info_posted = false;
+static bool labels_drawn = false;
+static unsigned render_line = InfoLine::Labels;
+static int shown_values[InfoLine::LinesCount] = {};
+static uint32_t max_job_cycles = 0;
+
+// display is not used after this number of jobs failed in a row
+// (it is disconnected or doesn't answer)
+constexpr unsigned MaxFailedJobs = 8;
+static bool job_sent = false;
+static uint32_t job_errors_count = 0; // display errors count when last job is sent
+static unsigned failed_jobs = 0;
+
+void post_cur_info(double angle, unsigned seconds_to_dithering, double dither_angle)
+{
+	posted_info = { angle, seconds_to_dithering, dither_angle };
+	info_posted = true;
+}
+
+// value of line as it is shown on screen
+static int get_line_value(unsigned line)
+{
+	switch (line)
+	{
+	case InfoLine::Angle:
+		return (int)lround(render_info.angle * 10);
+
+	case InfoLine::DitherTime:
+		return (int)render_info.seconds_to_dithering;
+
+	case InfoLine::DitherAngle:
+		return (int)lround(render_info.dither_angle * 10);
+	}
+
+	return 0;
+}
+
+static int get_line_y(unsigned line)
+{
+	const int line_height = 12 * mgfxpp::get_current_font()->height / 10;
+	return (line - InfoLine::Angle) * line_height;
+}
+
+static void render_labels()
+{
+	mgfxpp::display_draw([]
 	{
 		mgfxpp::set_current_font(mgfxpp::font_roboto_bold11_en);
 		mgfxpp::display_fill_rect(mgfxpp::display_get_clip_rect(), mgfxpp::Color::PixelOff);
+		mgfxpp::draw_string_at(0, get_line_y(InfoLine::Angle), "Angle");
+		mgfxpp::draw_string_at(0, get_line_y(InfoLine::DitherTime), "Dither time");
+		mgfxpp::draw_string_at(0, get_line_y(InfoLine::DitherAngle), "Dither angle");
+	});
+}
+
+static void render_value(unsigned line)
+{
+	mgfxpp::display_draw([&]
+	{
+		mgfxpp::set_current_font(mgfxpp::font_roboto_bold11_en);
 
-		int y = 0;
-		int x = 2 * mgfxpp::display_get_width() / 3;
-		mgfxpp::draw_string_at(0, y, "Angle");
-		mgfxpp::printf_at(x, y, u8": {:.1}°", angle);
-		y += 12 * mgfxpp::get_current_font()->height / 10;
+		const int y = get_line_y(line);
+		const int x = 2 * mgfxpp::display_get_width() / 3;
 
-		mgfxpp::draw_string_at(0, y, "Dither time");
-		mgfxpp::printf_at(x, y, ": {}:{:02}", seconds_to_dithering / 60U, seconds_to_dithering % 60U);
-		y += 12 * mgfxpp::get_current_font()->height / 10;
+		switch (line)
+		{
+		case InfoLine::Angle:
+			mgfxpp::printf_at(x, y, u8": {:.1}°", render_info.angle);
+			break;
 
-		mgfxpp::draw_string_at(0, y, "Dither angle");
-		mgfxpp::printf_at(x, y, u8": {:.1}°", dither_angle);
+		case InfoLine::DitherTime:
+			mgfxpp::printf_at(x, y, ": {}:{:02}", render_info.seconds_to_dithering / 60U, render_info.seconds_to_dithering % 60U);
+			break;
+
+		case InfoLine::DitherAngle:
+			mgfxpp::printf_at(x, y, u8": {:.1}°", render_info.dither_angle);
+			break;
+		}
+
+		// clear rest of line after text
+		int text_end = 0;
+		mgfxpp::get_text_draw_pos(&text_end, nullptr);
+		const int right = mgfxpp::display_get_width() - 1;
+		if (text_end <= right)
+			mgfxpp::fill_rect({text_end, y, right, y + mgfxpp::get_current_font()->height - 1});
 	});
 }
+
+void process_display()
+{
+	if (!is_display_ok()) return;
+
+	if (render_line == InfoLine::Labels)
+	{
+		if (!info_posted) return;
+		render_info = posted_info;
+		info_posted = false;
+		if (labels_drawn) render_line++;
+	}
+
+	// don't block on display connection while previous data is sent
+	if (is_display_busy()) return;
+
+	if (failed_jobs >= MaxFailedJobs) return;
+
+	// previous job is finished, it is failed if there were errors
+	uint32_t errors_count = get_display_errors_count();
+	if (job_sent)
+	{
+		failed_jobs = (errors_count != job_errors_count) ? failed_jobs + 1 : 0;
+		job_sent = false;
+		if (failed_jobs >= MaxFailedJobs)
+		{
+			debug_printf("Display doesn't answer, it is not updated any more\n");
+			return;
+		}
+	}
+
+	uint32_t start = get_cycles_counter();
+
+	if (render_line == InfoLine::Labels)
+	{
+		render_labels();
+		job_sent = true;
+		labels_drawn = true;
+		for (auto &value : shown_values) value = INT_MIN;
+		render_line++;
+	}
+	else
+	{
+		for (; render_line != InfoLine::LinesCount; render_line++)
+		{
+			int value = get_line_value(render_line);
+			if (value == shown_values[render_line]) continue;
+			render_value(render_line);
+			job_sent = true;
+			shown_values[render_line] = value;
+			render_line++;
+			break;
+		}
+	}
+
+	uint32_t cycles = get_cycles_counter() - start;
+	if (cycles > max_job_cycles) max_job_cycles = cycles;
+
+	job_errors_count = errors_count;
+
+	if (render_line == InfoLine::LinesCount)
+		render_line = InfoLine::Labels;
+}
+
+uint32_t get_display_job_max_cycles()
+{
+	return max_job_cycles;
+}
@@ -1,5 +1,14 @@
 #pragma once
 
+#include <stdint.h>
+
 void show_wellcome_screen();
 
-void show_cur_info(double angle, unsigned seconds_to_dithering, double dither_angle);
\ No newline at end of file
+// Posts values for info screen. Screen is rendered later by process_display()
+void post_cur_info(double angle, unsigned seconds_to_dithering, double dither_angle);
+
+// Renders one line of posted info screen. Must be called from main loop
+void process_display();
+
+// Worst time of one process_display() call (see get_cycles_counter())
+uint32_t get_display_job_max_cycles();
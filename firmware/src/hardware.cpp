@@ -1,17 +1,24 @@
 #include <math.h>
 #include <limits.h>
+#include <string.h>
 #include <libopencm3/stm32/rcc.h>
 #include <libopencm3/stm32/gpio.h>
 #include <libopencm3/stm32/timer.h>
 #include <libopencm3/stm32/usart.h>
 #include <libopencm3/stm32/adc.h>
 #include <libopencm3/stm32/i2c.h>
+#include <libopencm3/stm32/dma.h>
+#include <libopencm3/stm32/exti.h>
 #include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/cortex.h>
 
 #include "hardware.hpp"
+#include "step_speed.hpp"
+#include "profiling.hpp"
 #include "debug_printf.hpp"
 #include "mgfxpp/displays/mono_sh1106.hpp"
-#include "mgfxpp/connectors/libopencm3_display_i2c_v1_conn.hpp"
+#include "mgfxpp/connectors/libopencm3_display_i2c_dma_conn.hpp"
 #include "mgfxpp/mgfxpp_display.hpp"
 
 /* Helpers for GPIO port declarations like
@@ -39,6 +46,16 @@
 #define DITH_ANGL_BTN_PIN  GPIOA, GPIO7
 #define DITH_ANGL_GND_PIN  GPIOB, GPIO0
 
+// EXTI lines of buttons (line number is pin number)
+
+#define REVERT_BTN_EXTI    EXTI3
+#define DITH_TIME_BTN_EXTI EXTI5
+#define DITH_ANGL_BTN_EXTI EXTI7
+#define BTN_EXTI3_IRQ      NVIC_EXTI3_IRQ
+#define BTN_EXTI9_5_IRQ    NVIC_EXTI9_5_IRQ
+#define BTN_EXTI3_ISR      exti3_isr
+#define BTN_EXTI9_5_ISR    exti9_5_isr
+
 #define PRINT_PIN          GPIOA, GPIO9
 #define PRINTGND_PIN       GPIOA, GPIO10
 
@@ -52,9 +69,25 @@
 #define STEP_TIMER TIM2
 #define STEP_TIMER_RCC RCC_TIM2
 #define STEP_TIMER_RST RST_TIM2
-#define STEP_TIMER_IRQ NVIC_TIM2_IRQ
 #define STEP_TIMER_CHAN TIM_OC2
-#define STEP_TIMER_ISR tim2_isr
+
+// Timer counting step pulses. It is clocked by update event of step timer
+// (TIM2 TRGO is ITR1 of TIM4) and counts up or down by motor direction.
+// Compare interrupt stops limited step schedule
+
+#define STEP_COUNTER TIM4
+#define STEP_COUNTER_RCC RCC_TIM4
+#define STEP_COUNTER_RST RST_TIM4
+#define STEP_COUNTER_IRQ NVIC_TIM4_IRQ
+#define STEP_COUNTER_TRIGGER TIM_SMCR_TS_ITR1
+#define STEP_COUNTER_CHAN TIM_OC1
+#define STEP_COUNTER_ISR tim4_isr
+
+// DMA channel reloading step timer period from step schedule (TIM2_UP)
+
+#define STEP_TIMER_DMA DMA1
+#define STEP_TIMER_DMA_RCC RCC_DMA1
+#define STEP_TIMER_DMA_CHAN DMA_CHANNEL2
 
 // Timer for time intervals
 
@@ -68,50 +101,107 @@
 
 #define PRINT_USART USART1
 #define PRINT_USART_RCC RCC_USART1
+#define PRINT_USART_IRQ NVIC_USART1_IRQ
+#define PRINT_USART_ISR usart1_isr
 
 // i2c for display
 
 #define DISP_I2C I2C1
 #define DISP_I2C_RCC RCC_I2C1
+#define DISP_I2C_EV_IRQ NVIC_I2C1_EV_IRQ
+#define DISP_I2C_ER_IRQ NVIC_I2C1_ER_IRQ
+#define DISP_I2C_EV_ISR i2c1_ev_isr
+#define DISP_I2C_ER_ISR i2c1_er_isr
+
+// DMA channel for display i2c (I2C1_TX)
 
-constexpr float MaxStepMotorAccel = 20; // rotations in sec^2
+#define DISP_I2C_DMA DMA1
+#define DISP_I2C_DMA_RCC RCC_DMA1
+#define DISP_I2C_DMA_CHAN DMA_CHANNEL6
+#define DISP_I2C_DMA_IRQ NVIC_DMA1_CHANNEL6_IRQ
+#define DISP_I2C_DMA_ISR dma1_channel6_isr
 
-constexpr unsigned TimerClock = 1'000'000;
-constexpr unsigned RecalcMotorSpeedFreq = 100; // Hz
+// length of step pulse in step timer ticks
+constexpr unsigned StepPulseLen = (TimerClock / (MotorSteps*MotorMicroSteps*10)) /2 - 1; // 10 rotations per second maximum
+
+
+static StepSpeed step_speed;
+
+static bool step_timer_enabled = false;
+static volatile unsigned time_counter = 0;
+static volatile unsigned calc_steps_timer_cnt = 0;
+static volatile unsigned timer_event_time = 0;
+static volatile bool timer_event_set = false;
 
+static EventQueue event_queue;
 
-class Button
+// button inputs in order of ButtonId
+struct ButtonInput
 {
-public:
-	void tick(bool pressed)
+	uint32_t port;
+	uint16_t pin;
+	uint32_t exti;
+};
+
+static const ButtonInput button_inputs[] = {
+	{ GPIO_PORT(REVERT_BTN_PIN), GPIO_PIN(REVERT_BTN_PIN), REVERT_BTN_EXTI },
+	{ GPIO_PORT(DITH_TIME_BTN_PIN), GPIO_PIN(DITH_TIME_BTN_PIN), DITH_TIME_BTN_EXTI },
+	{ GPIO_PORT(DITH_ANGL_BTN_PIN), GPIO_PIN(DITH_ANGL_BTN_PIN), DITH_ANGL_BTN_EXTI },
+};
+
+static_assert(sizeof(button_inputs) / sizeof(button_inputs[0]) == (unsigned)ButtonId::Count);
+
+struct ButtonPort
+{
+	// buttons connect inputs with pull-up to ground
+	static bool is_pressed(unsigned button)
 	{
-		if (pressed && (pressed_cnt_ < 2 * PressBtnTimeMs * TimeTimerFreq / 1000))
-			pressed_cnt_++;
-		else if (!pressed && (pressed_cnt_ > 0))
-			pressed_cnt_--;
+		return !gpio_get(button_inputs[button].port, button_inputs[button].pin);
 	}
 
-	bool is_pressed_filtered() const
+	static void enable_edge_irq(unsigned button)
 	{
-		return pressed_cnt_ > (PressBtnTimeMs * TimeTimerFreq / 1000);
+		exti_reset_request(button_inputs[button].exti);
+		exti_enable_request(button_inputs[button].exti);
 	}
 
-private:
-	static constexpr uint16_t PressBtnTimeMs = 20;
-	volatile uint16_t pressed_cnt_ = 0;
+	static void disable_edge_irq(unsigned button)
+	{
+		exti_disable_request(button_inputs[button].exti);
+	}
+
+	static void notify()
+	{
+		event_queue.post(Event::Button);
+	}
 };
 
-static volatile float desired_rotations_per_seconds = 0;
-static volatile float current_rotations_per_seconds = 0;
+static ButtonEngine<ButtonPort, TimeTimerFreq> buttons;
 
-static bool step_timer_enabled = false;
-static volatile unsigned time_counter = 0;
-static Button revert_btn;
-static Button dither_time_btn;
-static Button dither_angle_btn;
-static volatile unsigned calc_steps_timer_cnt = 0;
+// CPU busy time is counted by main loop only
+static uint64_t busy_cycles = 0;
+static uint32_t awake_start = 0; // cycles counter at wake up
 
+// position is rebuilt from 16-bit hardware counter of step pulses
 static volatile int32_t steps_counter = 0;
+static volatile int32_t step_pulses = 0;          // step counter extended to 32 bits
+static volatile uint16_t step_counter_prev = 0;   // step counter value at last update
+
+// step schedule ring buffer. Values are reload values for step timer
+static uint16_t step_intervals[StepScheduleSize] = {};
+static unsigned step_intervals_wr_pos = 0;
+static volatile bool step_schedule_running = false;
+static volatile bool step_schedule_limited = false;
+static volatile int32_t step_schedule_end = 0;    // step_pulses value to stop limited schedule
+static volatile int32_t step_schedule_start = 0;  // step_pulses value at start of schedule
+static volatile uint32_t step_intervals_added = 0;
+static volatile uint32_t step_schedule_underruns = 0;  // steps made by intervals not written yet
+
+// debug UART transmit ring buffer. Written by main loop, read by USART interrupt
+static char uart_tx_buffer[DebugUartBufferSize] = {};
+static volatile unsigned uart_tx_wr_pos = 0;
+static volatile unsigned uart_tx_rd_pos = 0;
+static volatile uint32_t uart_tx_dropped = 0;
 
 void init_hardware()
 {
@@ -120,6 +210,11 @@ void init_hardware()
 	rcc_clock_setup_pll(&rcc_hse_configs[RCC_CLOCK_HSE8_72MHZ]);
 	rcc_periph_clock_enable(RCC_AFIO);
 
+	// CPU cycles counter
+
+	dwt_enable_cycle_counter();
+	awake_start = dwt_read_cycle_counter();
+
 	// GPIO ports
 
 	rcc_periph_clock_enable(RCC_GPIOA);
@@ -134,13 +229,14 @@ void init_hardware()
 	gpio_set_mode(GPIO_PORT(PRINT_PIN), GPIO_MODE_OUTPUT_50_MHZ, GPIO_CNF_OUTPUT_ALTFN_PUSHPULL, GPIO_PIN(PRINT_PIN));
 	gpio_set_mode(GPIO_PORT(PRINTGND_PIN), GPIO_MODE_OUTPUT_50_MHZ, GPIO_CNF_OUTPUT_OPENDRAIN, GPIO_PIN(PRINTGND_PIN));
 	rcc_periph_clock_enable(PRINT_USART_RCC);
-	usart_set_baudrate(PRINT_USART, 115200);
+	usart_set_baudrate(PRINT_USART, DebugUartBaudRate);
 	usart_set_databits(PRINT_USART, 8);
 	usart_set_stopbits(PRINT_USART, USART_STOPBITS_1);
 	usart_set_mode(PRINT_USART, USART_MODE_TX);
 	usart_set_parity(PRINT_USART, USART_PARITY_NONE);
 	usart_set_flow_control(PRINT_USART, USART_FLOWCONTROL_NONE);
 	usart_enable(PRINT_USART);
+	nvic_enable_irq(PRINT_USART_IRQ);
 
 	// led pin
 
@@ -157,18 +253,43 @@ void init_hardware()
 
 	rcc_periph_clock_enable(STEP_TIMER_RCC);
 	rcc_periph_reset_pulse(STEP_TIMER_RST);
-	nvic_enable_irq(STEP_TIMER_IRQ);
 	timer_set_mode(STEP_TIMER, TIM_CR1_CKD_CK_INT, TIM_CR1_CMS_EDGE, TIM_CR1_DIR_UP);
 	timer_set_prescaler(STEP_TIMER, (rcc_apb1_frequency*2)/TimerClock - 1);
 	timer_enable_preload(STEP_TIMER);
 	timer_set_period(STEP_TIMER, 1000);
 	timer_set_oc_mode(STEP_TIMER, STEP_TIMER_CHAN, TIM_OCM_PWM1);
 	timer_set_oc_polarity_high(STEP_TIMER, STEP_TIMER_CHAN);
-	timer_set_oc_value(STEP_TIMER, STEP_TIMER_CHAN, (TimerClock / (MotorSteps*MotorMicroSteps*10)) /2 - 1); // 10 rotations per second maximum
+	timer_set_oc_value(STEP_TIMER, STEP_TIMER_CHAN, StepPulseLen);
 	timer_enable_oc_output(STEP_TIMER, STEP_TIMER_CHAN);
+	timer_update_on_overflow(STEP_TIMER);
+	timer_set_master_mode(STEP_TIMER, TIM_CR2_MMS_UPDATE);
 	timer_generate_event(STEP_TIMER, TIM_EGR_UG);
 	timer_clear_flag(STEP_TIMER, TIM_SR_UIF);
-	timer_enable_irq(STEP_TIMER, TIM_DIER_UIE);
+
+	// step counter (started after update event generated above)
+
+	rcc_periph_clock_enable(STEP_COUNTER_RCC);
+	rcc_periph_reset_pulse(STEP_COUNTER_RST);
+	nvic_enable_irq(STEP_COUNTER_IRQ);
+	timer_set_period(STEP_COUNTER, 0xFFFF);
+	timer_slave_set_trigger(STEP_COUNTER, STEP_COUNTER_TRIGGER);
+	timer_slave_set_mode(STEP_COUNTER, TIM_SMCR_SMS_ECM1);
+	timer_direction_up(STEP_COUNTER);
+	timer_set_counter(STEP_COUNTER, 0);
+	timer_enable_counter(STEP_COUNTER);
+
+	// step schedule DMA (circular transfer from ring buffer into step timer period)
+
+	rcc_periph_clock_enable(STEP_TIMER_DMA_RCC);
+	dma_channel_reset(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN);
+	dma_set_peripheral_address(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN, (uint32_t)&TIM_ARR(STEP_TIMER));
+	dma_set_memory_address(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN, (uint32_t)step_intervals);
+	dma_set_read_from_memory(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN);
+	dma_enable_memory_increment_mode(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN);
+	dma_set_peripheral_size(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN, DMA_CCR_PSIZE_16BIT);
+	dma_set_memory_size(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN, DMA_CCR_MSIZE_16BIT);
+	dma_enable_circular_mode(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN);
+	dma_set_priority(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN, DMA_CCR_PL_VERY_HIGH);
 
 	// time timer
 
@@ -204,6 +325,18 @@ void init_hardware()
 	gpio_set_mode(GPIO_PORT(DITH_ANGL_GND_PIN), GPIO_MODE_OUTPUT_50_MHZ, GPIO_CNF_OUTPUT_OPENDRAIN, GPIO_PIN(DITH_ANGL_GND_PIN));
 	gpio_clear(DITH_ANGL_GND_PIN);
 
+	// buttons trigger EXTI on both edges
+
+	for (const auto &input : button_inputs)
+	{
+		exti_select_source(input.exti, input.port);
+		exti_set_trigger(input.exti, EXTI_TRIGGER_BOTH);
+		exti_reset_request(input.exti);
+		exti_enable_request(input.exti);
+	}
+	nvic_enable_irq(BTN_EXTI3_IRQ);
+	nvic_enable_irq(BTN_EXTI9_5_IRQ);
+
 	// i2c display connection
 
 	gpio_set_mode(GPIO_PORT(DISP_SDA_PIN), GPIO_MODE_OUTPUT_50_MHZ, GPIO_CNF_OUTPUT_ALTFN_OPENDRAIN, GPIO_PIN(DISP_SDA_PIN));
@@ -216,35 +349,272 @@ void init_hardware()
 	i2c_set_speed(DISP_I2C, i2c_speed_fm_400k, rcc_apb1_frequency / 1'000'000);
 	i2c_peripheral_enable(DISP_I2C);
 
+	rcc_periph_clock_enable(DISP_I2C_DMA_RCC);
+	nvic_enable_irq(DISP_I2C_EV_IRQ);
+	nvic_enable_irq(DISP_I2C_ER_IRQ);
+	nvic_enable_irq(DISP_I2C_DMA_IRQ);
+
 	debug_printf("Hardware initialized\n");
 	debug_printf("rcc_apb1_frequency = {} Mhz\n", rcc_apb1_frequency / 1'000'000);
 	debug_printf("rcc_apb2_frequency = {} Mhz\n", rcc_apb2_frequency / 1'000'000);
 	debug_printf("rcc_ahb_frequency = {} Mhz\n", rcc_ahb_frequency / 1'000'000);
 }
 
+// Adds step pulses counted by hardware since last call. Steps counter
+// can't go below zero (start of rod), LED is on when it is clamped
+static void update_steps_counter()
+{
+	uint16_t counter = timer_get_counter(STEP_COUNTER);
+	int16_t diff = (int16_t)(counter - step_counter_prev);
+	step_counter_prev = counter;
+	step_pulses += diff;
+
+	int32_t steps = steps_counter + diff;
+	if (steps < 0)
+	{
+		steps = 0;
+		led_on();
+	}
+	else if (diff)
+	{
+		led_off();
+	}
+	steps_counter = steps;
+}
+
+// motor direction and counting direction of step counter are changed together
+static void set_step_dir(bool forward)
+{
+	if (forward)
+	{
+		gpio_set(DIR_PIN);
+		timer_direction_up(STEP_COUNTER);
+	}
+	else
+	{
+		gpio_clear(DIR_PIN);
+		timer_direction_down(STEP_COUNTER);
+	}
+}
+
+static void stop_step_schedule()
+{
+	if (!step_schedule_running) return;
+
+	timer_disable_irq(STEP_TIMER, TIM_DIER_UDE);
+	dma_disable_channel(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN);
+	timer_enable_preload(STEP_TIMER);
+
+	step_speed.continue_schedule(TIM_ARR(STEP_TIMER) + 1, gpio_get(DIR_PIN));
+
+	step_schedule_running = false;
+
+	timer_disable_irq(STEP_COUNTER, TIM_DIER_CC1IE);
+	step_schedule_limited = false;
+}
+
+// last step of limited schedule is made, motor is stopped
+static void finish_step_schedule()
+{
+	timer_disable_counter(STEP_TIMER);
+	step_timer_enabled = false;
+
+	stop_step_schedule();
+	step_speed.stop();
+
+	event_queue.post(Event::MoveDone);
+}
+
 void set_rotations_per_seconds(float value)
 {
-	desired_rotations_per_seconds = value;
+	cm_disable_interrupts();
+	stop_step_schedule();
+	step_speed.set_desired(value);
+	cm_enable_interrupts();
+}
+
+float get_desired_rotations_per_seconds()
+{
+	return step_speed.get_desired();
+}
+
+float get_rotations_per_seconds()
+{
+	if (!step_schedule_running) return step_speed.get();
+
+	// step timer period is reloaded from schedule at each step
+	return StepSpeed::calc_speed(TIM_ARR(STEP_TIMER) + 1, gpio_get(DIR_PIN));
+}
+
+void reset_step_schedule()
+{
+	cm_disable_interrupts();
+
+	stop_step_schedule();
+
+	timer_disable_counter(STEP_TIMER);
+	step_timer_enabled = false;
+	step_speed.stop();
+
+	step_intervals_wr_pos = 0;
+	step_intervals_added = 0;
+
+	cm_enable_interrupts();
+}
+
+static unsigned get_step_schedule_rd_pos()
+{
+	if (!step_schedule_running) return 0;
+	return StepScheduleSize - DMA_CNDTR(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN);
+}
+
+unsigned get_step_schedule_free_space()
+{
+	unsigned used = (step_intervals_wr_pos + StepScheduleSize - get_step_schedule_rd_pos()) % StepScheduleSize;
+	return StepScheduleSize - used - 1;
+}
+
+bool add_step_interval(uint16_t interval)
+{
+	if (get_step_schedule_free_space() == 0) return false;
+	step_intervals[step_intervals_wr_pos] = interval - 1;
+	step_intervals_wr_pos = (step_intervals_wr_pos + 1) % StepScheduleSize;
+	step_intervals_added = step_intervals_added + 1;
+	return true;
+}
+
+void run_step_schedule(uint16_t first_interval, bool forward, uint32_t steps_count)
+{
+	cm_disable_interrupts();
+
+	stop_step_schedule();
+	timer_disable_counter(STEP_TIMER);
+
+	set_step_dir(forward);
+
+	// DMA starts from beginning of ring buffer at first step
+	dma_set_number_of_data(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN, StepScheduleSize);
+	dma_enable_channel(STEP_TIMER_DMA, STEP_TIMER_DMA_CHAN);
+
+	// Without preload period written by DMA at step is used for the
+	// next interval. Counter starts after step pulse to not make extra step
+	if (first_interval > USHRT_MAX - StepPulseLen)
+		first_interval = USHRT_MAX - StepPulseLen;
+	timer_disable_preload(STEP_TIMER);
+	timer_set_counter(STEP_TIMER, StepPulseLen);
+	timer_set_period(STEP_TIMER, first_interval + StepPulseLen - 1);
+	timer_enable_irq(STEP_TIMER, TIM_DIER_UDE);
+
+	update_steps_counter();
+	step_schedule_start = step_pulses;
+
+	// compare interrupt at the last step. It matches each 2^16 steps
+	// before it, so end is checked by extended counter
+	if (steps_count)
+	{
+		int32_t diff = forward ? (int32_t)steps_count : -(int32_t)steps_count;
+		step_schedule_end = step_pulses + diff;
+		step_schedule_limited = true;
+		timer_set_oc_value(STEP_COUNTER, STEP_COUNTER_CHAN, (uint16_t)(step_counter_prev + diff));
+		timer_clear_flag(STEP_COUNTER, TIM_SR_CC1IF);
+		timer_enable_irq(STEP_COUNTER, TIM_DIER_CC1IE);
+	}
+
+	step_schedule_running = true;
+	step_timer_enabled = true;
+	timer_enable_counter(STEP_TIMER);
+
+	cm_enable_interrupts();
+}
+
+bool is_step_schedule_running()
+{
+	return step_schedule_running;
+}
+
+uint32_t get_step_schedule_underruns()
+{
+	return step_schedule_underruns;
+}
+
+// Each step takes next interval from ring buffer by DMA, so more steps than
+// added intervals means DMA replays stale ones and DMA position used for free
+// space is wrong. Schedule is stopped and motor is slowed down to stop.
+// Interval after the last step of limited schedule is never used
+static void check_step_schedule_underrun()
+{
+	if (!step_schedule_running) return;
+
+	int32_t steps = step_pulses - step_schedule_start;
+	uint32_t steps_made = (steps < 0) ? -steps : steps;
+	if (steps_made <= step_intervals_added) return;
+	if (step_schedule_limited && (step_pulses == step_schedule_end)) return;
+
+	step_schedule_underruns = step_schedule_underruns + 1;
+	stop_step_schedule();
+	step_speed.set_desired(0);
 }
 
 void send_debug_uart_char(char chr)
 {
-	usart_send_blocking(PRINT_USART, (unsigned char)chr);
+	unsigned wr_pos = uart_tx_wr_pos;
+	unsigned next_pos = (wr_pos + 1) % DebugUartBufferSize;
+	if (next_pos == uart_tx_rd_pos)
+	{
+		uart_tx_dropped++;
+		return;
+	}
+
+	uart_tx_buffer[wr_pos] = chr;
+	uart_tx_wr_pos = next_pos;
+
+	usart_enable_tx_interrupt(PRINT_USART);
 }
 
-bool is_revert_btn_pressed()
+size_t send_debug_uart_text(const char* text, size_t len)
 {
-	return revert_btn.is_pressed_filtered();
+	unsigned wr_pos = uart_tx_wr_pos;
+	unsigned rd_pos = uart_tx_rd_pos;
+	unsigned free_space = (rd_pos + DebugUartBufferSize - wr_pos - 1) % DebugUartBufferSize;
+
+	if (len > free_space)
+	{
+		uart_tx_dropped += len - free_space;
+		len = free_space;
+	}
+	if (len == 0) return 0;
+
+	// text can wrap around end of buffer
+	unsigned first_len = DebugUartBufferSize - wr_pos;
+	if (first_len > len) first_len = len;
+	memcpy(uart_tx_buffer + wr_pos, text, first_len);
+	memcpy(uart_tx_buffer, text + first_len, len - first_len);
+
+	uart_tx_wr_pos = (wr_pos + len) % DebugUartBufferSize;
+
+	usart_enable_tx_interrupt(PRINT_USART);
+
+	return len;
 }
 
-bool is_dither_time_btn_pressed()
+uint32_t get_debug_uart_dropped_count()
 {
-	return dither_time_btn.is_pressed_filtered();
+	return uart_tx_dropped;
 }
 
-bool is_dither_angle_btn_pressed()
+size_t get_debug_uart_free_space()
 {
-	return dither_angle_btn.is_pressed_filtered();
+	return (uart_tx_rd_pos + DebugUartBufferSize - uart_tx_wr_pos - 1) % DebugUartBufferSize;
+}
+
+bool is_button_pressed(ButtonId button)
+{
+	return buttons.is_pressed((unsigned)button);
+}
+
+bool get_button_event(ButtonEvent &event)
+{
+	return buttons.get_event(event);
 }
 
 unsigned get_time_counter()
@@ -252,11 +622,57 @@ unsigned get_time_counter()
 	return time_counter;
 }
 
+// Must be called with interrupts disabled. Pending interrupt wakes core
+// up even if it is masked, it is handled after interrupts are enabled
+// again, so condition checked before sleep can't be missed
+static void sleep_until_interrupt()
+{
+	busy_cycles += dwt_read_cycle_counter() - awake_start;
+	__asm__ volatile ("wfi");
+	awake_start = dwt_read_cycle_counter();
+	cm_enable_interrupts();
+}
+
+Event wait_event()
+{
+	for (;;)
+	{
+		cm_disable_interrupts();
+		Event event = event_queue.get();
+		if (event != Event::None)
+		{
+			cm_enable_interrupts();
+			return event;
+		}
+		sleep_until_interrupt();
+	}
+}
+
+void set_timer_event(unsigned time_counter)
+{
+	cm_disable_interrupts();
+	timer_event_time = time_counter;
+	timer_event_set = true;
+	cm_enable_interrupts();
+}
+
 void delay_ms(unsigned delay_in_ms)
 {
 	auto start_cnt = time_counter;
 	auto max_diff = delay_in_ms * 1000U / TimeTimerFreq;
-	while ((time_counter - start_cnt) < max_diff) {}
+	for (;;)
+	{
+		cm_disable_interrupts();
+		if ((time_counter - start_cnt) >= max_diff) break;
+		sleep_until_interrupt();
+	}
+	cm_enable_interrupts();
+}
+
+uint64_t get_cpu_busy_us()
+{
+	uint64_t cycles = busy_cycles + (dwt_read_cycle_counter() - awake_start);
+	return cycles / (SysClockFreq / 1'000'000);
 }
 
 void led_on()
@@ -271,7 +687,11 @@ void led_off()
 
 int32_t get_steps_counter()
 {
-	return steps_counter;
+	cm_disable_interrupts();
+	update_steps_counter();
+	int32_t result = steps_counter;
+	cm_enable_interrupts();
+	return result;
 }
 
 uint32_t get_value_for_srand()
@@ -315,8 +735,13 @@ uint32_t get_value_for_srand()
 	return result;
 }
 
+uint32_t get_cycles_counter()
+{
+	return dwt_read_cycle_counter();
+}
+
 
-using DisplayConn = mgfxpp::LibOpenCM3_Display_I2C_V1_Conn<DISP_I2C, 0x78, 1'000'000>;
+using DisplayConn = mgfxpp::LibOpenCM3_Display_I2C_DMA_Conn<DISP_I2C, 0x78, DISP_I2C_DMA, DISP_I2C_DMA_CHAN, 1280, 10'000'000>;
 using Display = mgfxpp::sh1106_display<DisplayConn>;
 using BufferedDisplay = mgfxpp::MonoBufferedDisplay<Display>;
 
@@ -328,7 +753,14 @@ void init_display()
 {
 	debug_printf("Initializing display... ");
 
-	display_is_initialized = Display::init(false);
+	DisplayConn::init();
+
+	// init() only queues commands, display is found if they are sent without errors
+	uint32_t errors_count = DisplayConn::get_errors_count();
+	display_is_initialized =
+		Display::init(false) &&
+		DisplayConn::wait_transfer_finished() &&
+		(DisplayConn::get_errors_count() == errors_count);
 
 	debug_printf("{}\n", display_is_initialized ? "OK" : "FAILED!");
 
@@ -347,33 +779,59 @@ bool is_display_ok()
 	return display_is_initialized;
 }
 
-static void calc_steps_timer_period()
+uint32_t get_display_errors_count()
 {
-	float cur_speed = current_rotations_per_seconds;
-	constexpr float max_v_step = MaxStepMotorAccel / RecalcMotorSpeedFreq;
-	float v_step = desired_rotations_per_seconds - cur_speed;
-	if (v_step > max_v_step)
-		v_step = max_v_step;
-	else if (v_step < -max_v_step)
-		v_step = -max_v_step;
-
-	cur_speed += v_step;
+	return DisplayConn::get_errors_count();
+}
 
-	current_rotations_per_seconds = cur_speed;
+bool is_display_busy()
+{
+	return !DisplayConn::is_transfer_finished();
+}
 
-	float abs_speed = fabs(cur_speed);
+extern "C" void PRINT_USART_ISR()
+{
+	if (!usart_get_flag(PRINT_USART, USART_SR_TXE)) return;
 
-	if (abs_speed > 1e-5)
+	unsigned rd_pos = uart_tx_rd_pos;
+	if (rd_pos == uart_tx_wr_pos)
 	{
-		float steps_in_second = abs_speed / TurnsOnStep;
-		uint32_t reload_value = (uint32_t)(TimerClock / steps_in_second + 0.5);
-		if (reload_value > USHRT_MAX) reload_value = USHRT_MAX;
-		timer_set_period(STEP_TIMER, reload_value - 1);
+		// buffer is empty. Interrupt is enabled again by send_debug_uart_char()
+		usart_disable_tx_interrupt(PRINT_USART);
+		return;
+	}
+
+	usart_send(PRINT_USART, (uint8_t)uart_tx_buffer[rd_pos]);
+	uart_tx_rd_pos = (rd_pos + 1) % DebugUartBufferSize;
+}
+
+extern "C" void DISP_I2C_EV_ISR()
+{
+	DisplayConn::on_i2c_event();
+	if (DisplayConn::is_transfer_finished())
+		event_queue.post(Event::DisplayReady);
+}
+
+extern "C" void DISP_I2C_ER_ISR()
+{
+	DisplayConn::on_i2c_error();
+	if (DisplayConn::is_transfer_finished())
+		event_queue.post(Event::DisplayReady);
+}
+
+extern "C" void DISP_I2C_DMA_ISR()
+{
+	DisplayConn::on_dma_complete();
+}
+
+static void calc_steps_timer_period()
+{
+	ProfScope prof_scope(ProfSection::CalcStepsPeriod);
 
-		if (cur_speed > 0.0f)
-			gpio_set(DIR_PIN);
-		else
-			gpio_clear(DIR_PIN);
+	if (step_speed.update())
+	{
+		timer_set_period(STEP_TIMER, step_speed.get_reload_value() - 1);
+		set_step_dir(step_speed.is_forward());
 
 		if (!step_timer_enabled)
 		{
@@ -390,40 +848,68 @@ static void calc_steps_timer_period()
 
 extern "C" void TIME_TIMER_ISR()
 {
+	ProfScope prof_scope(ProfSection::TimeTimerIsr);
+
 	if (timer_get_flag(TIME_TIMER, TIM_SR_UIF))
 	{
 		timer_clear_flag(TIME_TIMER, TIM_SR_UIF);
 		++time_counter;
 
-		revert_btn.tick(!gpio_get(REVERT_BTN_PIN));
-		dither_time_btn.tick(!gpio_get(DITH_TIME_BTN_PIN));
-		dither_angle_btn.tick(!gpio_get(DITH_ANGL_BTN_PIN));
+		// counter must be read before 2^15 steps are made
+		update_steps_counter();
+		check_step_schedule_underrun();
+
+		buttons.tick(time_counter);
+
+		if (timer_event_set && ((int32_t)(time_counter - timer_event_time) >= 0))
+		{
+			timer_event_set = false;
+			event_queue.post(Event::Timer);
+		}
 
 		++calc_steps_timer_cnt;
 		if (calc_steps_timer_cnt >= TimeTimerFreq/RecalcMotorSpeedFreq)
 		{
-			calc_steps_timer_period();
+			if (!step_schedule_running)
+				calc_steps_timer_period();
 			calc_steps_timer_cnt = 0;
 		}
 	}
 }
 
-extern "C" void STEP_TIMER_ISR()
+// edge of button input starts its debouncing
+static void on_button_exti()
 {
-	if (timer_get_flag(STEP_TIMER, TIM_SR_UIF))
+	for (unsigned i = 0; i < (unsigned)ButtonId::Count; i++)
 	{
-		timer_clear_flag(STEP_TIMER, TIM_SR_UIF);
+		uint32_t exti = button_inputs[i].exti;
+		if (!(EXTI_IMR & exti) || !exti_get_flag_status(exti)) continue;
+		exti_reset_request(exti);
+		buttons.on_edge(i, time_counter);
+	}
+}
 
-		int32_t inc = 1;
-		steps_counter += gpio_get(DIR_PIN) ? inc : -inc;
-		if (steps_counter < 0)
-		{
-			steps_counter = 0;
-			led_on();
-		}
-		else
-		{
-			led_off();
-		}
+extern "C" void BTN_EXTI3_ISR()
+{
+	on_button_exti();
+}
+
+extern "C" void BTN_EXTI9_5_ISR()
+{
+	on_button_exti();
+}
+
+extern "C" void STEP_COUNTER_ISR()
+{
+	ProfScope prof_scope(ProfSection::StepCounterIsr);
+
+	if (timer_get_flag(STEP_COUNTER, TIM_SR_CC1IF))
+	{
+		timer_clear_flag(STEP_COUNTER, TIM_SR_CC1IF);
+
+		update_steps_counter();
+
+		if (step_schedule_limited && (step_pulses == step_schedule_end))
+			finish_step_schedule();
 	}
 }
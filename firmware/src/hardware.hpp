@@ -1,30 +1,88 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "config.hpp"
+#include "event_queue.hpp"
+#include "buttons.hpp"
 
 constexpr unsigned SysClockFreq = 72'000'000;
 constexpr unsigned APB1Freq = 36'000'000;
 
+// typical MCU supply current at SysClockFreq with all peripherals
+// enabled (STM32F103 datasheet), used for estimation of average current
+constexpr float McuRunCurrentMa = 36.0f;
+constexpr float McuSleepCurrentMa = 14.4f;
+
 constexpr double TurnsOnStep = 1.0 / (MotorSteps * MotorMicroSteps); // rod rotations per one motor step
 
 constexpr unsigned TimeTimerFreq = 1'000; // Hz
 
+constexpr unsigned TimerClock = 1'000'000; // step timer clock, Hz
+
+constexpr float MaxStepMotorAccel = 20; // rotations in sec^2
+
+constexpr unsigned StepScheduleSize = 256; // intervals in step schedule ring buffer (80 ms of fastest move)
+
+constexpr unsigned DebugUartBaudRate = 115200;
+constexpr unsigned DebugUartBufferSize = 1024; // debug UART transmit ring buffer
+
 void init_hardware();
 
 void set_rotations_per_seconds(float value);
+float get_desired_rotations_per_seconds();
+float get_rotations_per_seconds(); // current speed (of step schedule too)
+
+/* Step schedule. Step timer period is reloaded on each step from ring buffer
+   of intervals between steps (in TimerClock ticks) instead of speed.
+   set_rotations_per_seconds() stops schedule and returns to speed mode.
+   If steps_count is not 0, step timer interrupt stops schedule and motor
+   right after this number of steps (move to target position) and
+   Event::MoveDone is posted. If steps are made faster than intervals are
+   added (underrun), schedule is stopped and motor is slowed down to stop
+   in speed mode */
+
+void reset_step_schedule();
+bool add_step_interval(uint16_t interval);
+unsigned get_step_schedule_free_space();
+void run_step_schedule(uint16_t first_interval, bool forward = true, uint32_t steps_count = 0);
+bool is_step_schedule_running();
+uint32_t get_step_schedule_underruns();
+
+/* Debug UART. Characters are put into ring buffer and sent by interrupt,
+   so send_debug_uart_char() never waits. Characters not fitting into
+   full buffer are dropped and counted. send_debug_uart_text() copies whole
+   text at once and returns number of characters put into buffer */
 
 void send_debug_uart_char(char chr);
+size_t send_debug_uart_text(const char* text, size_t len);
+uint32_t get_debug_uart_dropped_count();
+size_t get_debug_uart_free_space();
+
+/* Buttons. Debounced state changes, long presses and repeats of held
+   buttons are put into queue of button events, Event::Button is posted
+   when new button event is put */
 
-bool is_revert_btn_pressed();
-bool is_dither_time_btn_pressed();
-bool is_dither_angle_btn_pressed();
+bool is_button_pressed(ButtonId button);
+bool get_button_event(ButtonEvent &event); // returns false if queue is empty
 
 unsigned get_time_counter();
 
+/* Main loop sleeps (WFI) until interrupt posts event. delay_ms() sleeps
+   between time timer interrupts too. Time from wake up to next sleep
+   (with interrupts handled in it) is counted as CPU busy time */
+
+Event wait_event();
+
+// Event::Timer is posted once when time counter reaches this value
+// (at the next tick if it is already passed)
+void set_timer_event(unsigned time_counter);
+
 void delay_ms(unsigned delay_in_ms);
 
+uint64_t get_cpu_busy_us();
+
 void led_on();
 
 void led_off();
@@ -33,6 +91,12 @@ int32_t get_steps_counter();
 
 uint32_t get_value_for_srand();
 
+uint32_t get_cycles_counter(); // CPU cycles (nanoseconds in host simulation)
+
 void init_display();
 
-bool is_display_ok();
\ No newline at end of file
+bool is_display_ok(); // display is found at init_display()
+
+uint32_t get_display_errors_count(); // failed transfers to display
+
+bool is_display_busy(); // display data is still being sent, Event::DisplayReady is posted when it is done
\ No newline at end of file
@@ -1,204 +1,236 @@
 #include <stdint.h>
 #include <string.h>
+#include <stdlib.h>
 #include <math.h>
 
 #include "hardware.hpp"
 #include "debug_printf.hpp"
 #include "gfx.hpp"
+#include "tracking_math.hpp"
+#include "motion.hpp"
+#include "profiling.hpp"
+#include "telemetry.hpp"
+#include "scheduler.hpp"
+
+constexpr unsigned MotionUpdatePeriodMs = 10;
+
+// rod is moved back while Revert button is held. Press again in
+// RevertPauseMs after release moves it forward, and so on
+constexpr int RevertRotPerSec = -5;
+constexpr unsigned RevertPauseMs = 300;
+
+// main loop jobs (see scheduler.hpp)
+static void on_motion_time();
+static void on_tracking_time();
+static void on_dither_time();
+static void on_telemetry_time();
+static void on_prof_dump_time();
+static void on_revert_time();
+
+static SchedJob motion_job = { on_motion_time };
+static SchedJob tracking_job = { on_tracking_time };
+static SchedJob dither_job = { on_dither_time };
+static SchedJob telemetry_job = { on_telemetry_time };
+static SchedJob prof_dump_job = { on_prof_dump_time };
+static SchedJob revert_job = { on_revert_time };
 
-constexpr double Pi = 3.141592653589793;
-constexpr double TurnPeriod = 23.0 /*H*/ * 3600.0 + 56.0 /*M*/ * 60.0 + 4.0 /*S*/;
-constexpr double RotSpeed = 2 * Pi / TurnPeriod;
-
-template <uint32_t Freq>
-class PeriodicalTimer
-{
-public:
-	void reset(uint32_t cur_time)
-	{
-		prev_value_ = cur_time;
-	}
-
-	bool is_signaled(uint32_t cur_time, uint32_t period)
-	{
-		if ((cur_time - prev_value_) >= period)
-		{
-			prev_value_ = cur_time;
-			return true;
-		}
-
-		return false;
-	}
-
-	uint32_t get_seconds_to_tick(uint32_t cur_time, uint32_t period)
-	{
-		if (cur_time < prev_value_) return 0;
-
-		auto from_time = cur_time - prev_value_;
-		if (from_time >= period) return 0;
-
-		return (period - from_time) / Freq;
-	}
-
-private:
-	uint32_t prev_value_ = 0;
-};
-
-static double start_angle = 0;
-static PeriodicalTimer<TimeTimerFreq> dither_timer;
-static unsigned start_time_counter = 0;
 static unsigned dither_period = MovePeriod; // in minutes
 static double dither_angle = MoveMaxAngle;
+static bool dithering = false;
+static bool reverting = false;
+static int revert_rot_per_sec = 0;
+static unsigned move_start_time = 0;
+static bool info_changed = false; // info screen must be updated
+static uint32_t loop_start = 0; // cycles counter at start of main loop iteration
+static uint32_t max_loop_cycles = 0; // worst main loop iteration without profile dump
+static uint32_t reported_uart_dropped = 0;
+static uint32_t telemetry_dropped = 0; // frames not fitting into debug UART buffer
+static uint32_t reported_telemetry_dropped = 0;
+static uint32_t handled_underruns = 0;
+static uint64_t telemetry_time = 0; // time counter extended to 64 bits
+static unsigned telemetry_prev_tm_cnt = 0;
 
 /*****************************************************************************/
 
-static double calc_angle(double l)
+static TrackingFloat get_l()
 {
-	return 2 * asin(l / (2 * R));
+	return steps_to_l<TrackingFloat>(get_steps_counter());
 }
 
-static double calc_l(double angle)
+template <typename Fun>
+static uint32_t measure_cycles(const Fun &fun)
 {
-	return 2 * R * sin(angle / 2);
+	constexpr unsigned count = 16;
+	volatile TrackingFloat result = fun(StartL);
+	uint32_t start = get_cycles_counter();
+	for (unsigned i = 0; i < count; i++)
+		result = fun(StartL + (MaxL - StartL) * i / count);
+	(void)result;
+	return (get_cycles_counter() - start) / count;
 }
 
-static double calc_ideal_angle()
+static void print_speed_calc_cycles()
 {
-	double time_in_sec = (double)(get_time_counter() - start_time_counter) / (double)TimeTimerFreq;
-	return start_angle + time_in_sec * RotSpeed;
+	debug_printf(
+		"Rod speed calc cycles: numeric = {}, analytic = {} (using {})\n",
+		measure_cycles(calc_l_speed_numeric),
+		measure_cycles(calc_l_speed_analytic<TrackingFloat>),
+		(RodSpeedCalc == RodSpeedMethod::Numeric) ? "numeric" : "analytic"
+	);
 }
 
-static double get_l()
+static void print_format_cycles()
 {
-	return get_steps_counter() * RodStep * TurnsOnStep + StartL;
+	constexpr unsigned count = 16;
+	char buffer[32];
+	uint32_t start = get_cycles_counter();
+	for (unsigned i = 0; i < count; i++)
+		mf::format(buffer, MF_FMT("{:.5}"), 19.01444 + i * 1e-5);
+	debug_printf("Float format cycles: {}\n", (get_cycles_counter() - start) / count);
 }
 
-static void recalc_speed(bool store_angle)
+// next dither move is made dither_period minutes from now
+static void restart_dither_timer()
 {
-	double l = get_l();
-	if (l > MaxL)
+	if (dither_period)
 	{
-		set_rotations_per_seconds(0);
-		return;
+		unsigned period = TimeTimerFreq * dither_period * 60;
+		sched_start(dither_job, get_time_counter() + period, period);
 	}
+	else
+	{
+		sched_stop(dither_job);
+	}
+}
 
-	double angle = calc_angle(l);
-
-	constexpr double d_angle = 1e-8;
+static void update_tracking(bool store_angle)
+{
+	TrackingFloat l = get_l();
+	if (l > (TrackingFloat)MaxL) return;
 
-	double l1 = calc_l(angle + d_angle);
-	double l2 = calc_l(angle - d_angle);
-	double dl = l1 - l2;
-	constexpr double dt = 2 * d_angle / RotSpeed;
-	double v = dl / dt; // mm in second
+	TrackingFloat angle = calc_angle(l);
 
-	double rod_rotataions_v = v / RodStep; // rod rotations in second
+	TrackingFloat v = calc_l_speed(l); // mm in second
 
-	set_rotations_per_seconds((float)rod_rotataions_v);
+	TrackingFloat rod_rotataions_v = v / (TrackingFloat)RodStep; // rod rotations in second
 
 	if (store_angle)
 	{
-		start_time_counter = get_time_counter();
-		dither_timer.reset(start_time_counter);
-		start_angle = angle;
-		debug_printf("Angle stored {:.5}\n", 180.0*start_angle/Pi);
+		restart_dither_timer();
+		debug_printf("Angle stored {:.5}\n", 180.0*angle/Pi);
 	}
 
+	// tracking data is sent by telemetry frames
+	if (TelemetryPeriodMs != 0) return;
+
+	const auto &err = motion_get_error_stat();
+
 	debug_printf(
-		"angle = {:.5}, rot_per_secs = {:.5} angle_diff = {:+.5}\n",
+		MF_FMT("angle = {:.5}, rot_per_secs = {:.5} angle_diff = {:+.5} track_err = {:+.2} (min {:+.2}, max {:+.2}, rms {:.2}) loop_max = {} (display {})\n"),
 		180.0*angle/Pi,
 		rod_rotataions_v,
-		180.0*(angle - calc_ideal_angle())/Pi
+		180.0*(angle - motion_get_ideal_angle())/Pi,
+		err.last,
+		err.min,
+		err.max,
+		err.get_rms(),
+		max_loop_cycles,
+		get_display_job_max_cycles()
 	);
 }
 
-static void make_random_move()
+static unsigned get_seconds_to_dithering()
 {
-	set_rotations_per_seconds(0);
-
-	if (get_l() >= MaxL) return;
-
-	double MoveMaxAngleRad = Pi * dither_angle / 180.0;
+	return sched_get_time_left(dither_job, get_time_counter()) / TimeTimerFreq;
+}
 
-	double angle_diff = MoveMaxAngleRad * (double)(rand() - RAND_MAX/2) / (double)RAND_MAX;
-	debug_printf("Move. angle_diff={:.5}\n", 180.0*angle_diff/Pi);
+static TelemetryState get_telemetry_state()
+{
+	if (reverting) return TelemetryState::Reverting;
+	if (dithering) return TelemetryState::Dithering;
+	return motion_is_tracking() ? TelemetryState::Tracking : TelemetryState::Idle;
+}
 
-	auto make_move = [&] (const float speed)
+static void send_telemetry()
+{
+	if constexpr (TelemetryPeriodMs != 0)
 	{
-		double prev_diff_abs = NAN;
-		bool prev_decrease = false;
-		bool first_time = true;
-		for (;;)
+		// frames are sent much more often than time counter wraps
+		auto tm_cnt = get_time_counter();
+		telemetry_time += tm_cnt - telemetry_prev_tm_cnt;
+		telemetry_prev_tm_cnt = tm_cnt;
+
+		TelemetryFrame frame;
+		frame.time_ms = telemetry_time * 1000 / TimeTimerFreq;
+		frame.steps = get_steps_counter();
+		frame.commanded_rps = is_step_schedule_running() ? motion_get_speed() : get_desired_rotations_per_seconds();
+		frame.current_rps = get_rotations_per_seconds();
+		frame.angle_error = motion_get_error_stat().last;
+		frame.seconds_to_dither = get_seconds_to_dithering();
+		frame.state = get_telemetry_state();
+
+		uint8_t buffer[TelemetryEncodedMaxSize];
+		unsigned size = telemetry_encode(frame, buffer);
+
+		// part of frame is useless, so frame is dropped whole
+		if (get_debug_uart_free_space() < size)
 		{
-			double new_angle = calc_ideal_angle() + angle_diff;
-			double l = get_l();
-			double cur_angle = calc_angle(l);
-			double diff = new_angle - cur_angle;
-			if ((diff < 0) && (l < (StartL + 1.0f))) break;
-			if ((diff > 0) && (l > MaxL)) break;
-			double diff_abs = fabs(diff);
-			bool cur_dir = (diff > 0);
-
-			if (!isnan(prev_diff_abs))
-			{
-				bool diff_decrease = (diff_abs < prev_diff_abs);
-				if (!diff_decrease && prev_decrease) break;
-				prev_decrease = diff_decrease;
-			}
-
-			set_rotations_per_seconds(cur_dir ? speed : -speed);
-			prev_diff_abs = diff_abs;
-			if (first_time) delay_ms(20);
+			telemetry_dropped++;
+			return;
 		}
-	};
-
-	make_move(1.00f);
-	make_move(0.05f);
+		send_debug_uart_text((const char*)buffer, size);
+	}
 }
 
-static void revert()
+static void report_uart_dropped()
 {
-	int rot_per_sec = -5;
+	uint32_t dropped = get_debug_uart_dropped_count();
+	if (dropped != reported_uart_dropped)
+	{
+		debug_printf("Debug UART dropped {} chars\n", dropped - reported_uart_dropped);
+		reported_uart_dropped = dropped;
+	}
 
-	for (;;)
+	if (telemetry_dropped != reported_telemetry_dropped)
 	{
-		set_rotations_per_seconds(rot_per_sec);
-		for (;;)
-		{
-			bool revert_btn_pressed = is_revert_btn_pressed();
-			if (!revert_btn_pressed) break;
-			delay_ms(10);
-		}
+		debug_printf("Telemetry dropped {} frames\n", telemetry_dropped - reported_telemetry_dropped);
+		reported_telemetry_dropped = telemetry_dropped;
+	}
+}
 
-		set_rotations_per_seconds(0);
+// Starts dither move by random angle. Move is made by motion engine
+// while main loop is running, returns false if rod is not moved
+static bool start_random_move()
+{
+	ProfScope prof_scope(ProfSection::RandomMove);
 
-		delay_ms(300);
+	if (get_l() >= MaxL) return false;
 
-		if (!is_revert_btn_pressed()) break;
+	double MoveMaxAngleRad = Pi * dither_angle / 180.0;
 
-		rot_per_sec = -rot_per_sec;
-	}
+	TrackingFloat angle_diff = MoveMaxAngleRad * (double)(rand() - RAND_MAX/2) / (double)RAND_MAX;
+	debug_printf("Move. angle_diff={:.5}\n", 180.0*angle_diff/Pi);
+
+	return motion_start_move(angle_diff);
 }
 
 
 static void start_work(bool store_angle)
 {
-	recalc_speed(store_angle);
+	motion_start_tracking(store_angle);
+	update_tracking(store_angle);
 }
 
 static void show_info_data()
 {
-	double angle = calc_angle(get_l());
-	double min_angle = calc_angle(StartL);
+	ProfScope prof_scope(ProfSection::ShowInfo);
 
-	unsigned time_to_dithrering =
-		dither_period
-		? dither_timer.get_seconds_to_tick(get_time_counter(), TimeTimerFreq * dither_period * 60)
-		: 0;
+	TrackingFloat angle = calc_angle(get_l());
+	TrackingFloat min_angle = calc_angle((TrackingFloat)StartL);
 
-	show_cur_info(
+	post_cur_info(
 		180.0 * (angle - min_angle) / Pi,
-		time_to_dithrering,
+		get_seconds_to_dithering(),
 		dither_angle
 	);
 }
@@ -207,7 +239,7 @@ static void change_dithering_time()
 {
 	if (dither_period) --dither_period;
 	else dither_period = MovePeriod;
-	dither_timer.reset(get_time_counter());
+	restart_dither_timer();
 }
 
 static void change_dithering_angle()
@@ -226,6 +258,114 @@ static void change_dithering_angle()
 	}
 }
 
+// main loop keeps running while reverting, dither moves are not started
+static void on_revert_button(ButtonAction action)
+{
+	if (action == ButtonAction::Press)
+	{
+		if (reverting)
+		{
+			// pressed again in pause
+			sched_stop(revert_job);
+			revert_rot_per_sec = -revert_rot_per_sec;
+		}
+		else
+		{
+			reverting = true;
+			dithering = false;
+			revert_rot_per_sec = RevertRotPerSec;
+		}
+		set_rotations_per_seconds(revert_rot_per_sec);
+	}
+	else if ((action == ButtonAction::Release) && reverting)
+	{
+		set_rotations_per_seconds(0);
+		sched_start(revert_job, get_time_counter() + RevertPauseMs * TimeTimerFreq / 1000);
+	}
+}
+
+// button is not pressed again in pause, tracking starts from new position
+static void on_revert_time()
+{
+	reverting = false;
+	start_work(true);
+	info_changed = true;
+}
+
+// dither settings are changed by press and then repeatedly while button is held
+static void handle_button_event(const ButtonEvent &event)
+{
+	if (event.button == ButtonId::Revert)
+	{
+		on_revert_button(event.action);
+		return;
+	}
+
+	if (event.action == ButtonAction::Release) return;
+
+	switch (event.button)
+	{
+
+	case ButtonId::DitherTime:
+		change_dithering_time();
+		break;
+
+	case ButtonId::DitherAngle:
+		change_dithering_angle();
+		break;
+
+	default:
+		return;
+	}
+
+	info_changed = true;
+}
+
+static void on_motion_time()
+{
+	ProfScope prof_scope(ProfSection::MotionUpdate);
+
+	// motor is stopped after schedule underrun, tracking is restarted
+	// from current position. Stopped move is finished as done
+	uint32_t underruns = get_step_schedule_underruns();
+	if (underruns != handled_underruns)
+	{
+		debug_printf("Step schedule underruns {}\n", underruns - handled_underruns);
+		handled_underruns = underruns;
+		if (!dithering && !reverting) start_work(false);
+		return;
+	}
+
+	motion_update();
+}
+
+static void on_tracking_time()
+{
+	update_tracking(false);
+	report_uart_dropped();
+	info_changed = true;
+}
+
+static void on_dither_time()
+{
+	if (dithering || reverting) return;
+	dithering = start_random_move();
+	if (!dithering) start_work(false);
+	move_start_time = get_time_counter();
+	info_changed = true;
+}
+
+static void on_telemetry_time()
+{
+	send_telemetry();
+}
+
+static void on_prof_dump_time()
+{
+	prof_dump();
+	loop_start = get_cycles_counter();
+}
+
 int main()
 {
 	init_hardware();
@@ -240,59 +380,61 @@ int main()
 	debug_printf("value_for_srand={} (0x{:x})\n", srand_value, srand_value);
 	srand(srand_value);
 
-	start_work(true);
+	// boot time measurements are diagnostics only
+	if constexpr (ProfilingEnabled)
+	{
+		print_speed_calc_cycles();
+		print_format_cycles();
+	}
 
-	PeriodicalTimer<TimeTimerFreq> recalc_speed_timer;
+	start_work(true);
 
-	dither_timer.reset(get_time_counter());
-	recalc_speed_timer.reset(get_time_counter());
+	auto tm_cnt = get_time_counter();
+	sched_start(motion_job, tm_cnt, MotionUpdatePeriodMs * TimeTimerFreq / 1000);
+	sched_start(tracking_job, tm_cnt + TimeTimerFreq / 2, TimeTimerFreq / 2);
+	if (TelemetryPeriodMs != 0)
+		sched_start(telemetry_job, tm_cnt, TelemetryPeriodMs * TimeTimerFreq / 1000);
+	if (ProfilingEnabled)
+		sched_start(prof_dump_job, tm_cnt + TimeTimerFreq * ProfDumpPeriod, TimeTimerFreq * ProfDumpPeriod);
 
-	bool prev_dither_time_btn_pressed = false;
-	bool prev_dither_angle_btn_pressed = false;
 	for (;;)
 	{
-		delay_ms(10);
-		auto tm_cnt = get_time_counter();
+		// sleep until the first job or other event
+		unsigned deadline;
+		if (sched_get_next_deadline(deadline))
+			set_timer_event(deadline);
 
-		bool show_info = false;
+		Event event = wait_event();
+		loop_start = get_cycles_counter();
 
-		if (is_revert_btn_pressed())
+		if (event == Event::Button)
 		{
-			revert();
-			start_work(true);
-			dither_timer.reset(tm_cnt);
-			show_info = true;
+			ButtonEvent btn_event;
+			while (get_button_event(btn_event))
+				handle_button_event(btn_event);
 		}
 
-		bool dither_time_btn_pressed = is_dither_time_btn_pressed();
-		if (dither_time_btn_pressed && !prev_dither_time_btn_pressed)
-		{
-			change_dithering_time();
-			show_info = true;
-		}
-		prev_dither_time_btn_pressed = dither_time_btn_pressed;
+		sched_run(get_time_counter());
 
-		bool dither_angle_btn_pressed = is_dither_angle_btn_pressed();
-		if (dither_angle_btn_pressed && !prev_dither_angle_btn_pressed)
+		// last step of move is made (Event::MoveDone)
+		if (dithering && !motion_is_moving())
 		{
-			change_dithering_angle();
-			show_info = true;
+			dithering = false;
+			debug_printf("Move done in {} ms\n", (get_time_counter() - move_start_time) * 1000 / TimeTimerFreq);
+			start_work(false);
+			info_changed = true;
 		}
-		prev_dither_angle_btn_pressed = dither_angle_btn_pressed;
 
-		if (recalc_speed_timer.is_signaled(tm_cnt, TimeTimerFreq / 2))
+		if (info_changed)
 		{
-			recalc_speed(false);
-			show_info = true;
+			show_info_data();
+			info_changed = false;
 		}
 
-		if (dither_period && dither_timer.is_signaled(tm_cnt, TimeTimerFreq * dither_period * 60))
-		{
-			make_random_move();
-			start_work(false);
-			show_info = true;
-		}
+		// next line of info screen is sent after Event::DisplayReady
+		process_display();
 
-		if (show_info) show_info_data();
+		uint32_t loop_cycles = get_cycles_counter() - loop_start;
+		if (loop_cycles > max_loop_cycles) max_loop_cycles = loop_cycles;
 	}
 }
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <libopencm3/stm32/i2c.h>
+#include <libopencm3/stm32/dma.h>
+#include <libopencm3/cm3/cortex.h>
+
+namespace mgfxpp {
+
+/* Non-blocking I2C display connection for STM32F1 (I2C v1) by DMA.
+
+   Commands and data are put into queue as I2C transactions (control byte
+   and payload). Consecutive commands are merged into one transaction.
+   Transactions are sent by DMA and driven by interrupts, so send_command(),
+   send_data() and finish_send_data() return immediately while queue has
+   free space. Caller has to route interrupts into on_i2c_event(),
+   on_i2c_error() and on_dma_complete() and to enable them in NVIC.
+   I2C peripheral and DMA clock must be initialized before init() */
+
+template <uintptr_t i2c, uint8_t addr, uintptr_t dma, uint8_t dma_channel, unsigned QueueSize = 1280, uint32_t time_out = 0>
+class LibOpenCM3_Display_I2C_DMA_Conn
+{
+public:
+	static void init()
+	{
+		dma_channel_reset(dma, dma_channel);
+		dma_set_peripheral_address(dma, dma_channel, (uint32_t)&I2C_DR(i2c));
+		dma_set_read_from_memory(dma, dma_channel);
+		dma_enable_memory_increment_mode(dma, dma_channel);
+		dma_set_peripheral_size(dma, dma_channel, DMA_CCR_PSIZE_8BIT);
+		dma_set_memory_size(dma, dma_channel, DMA_CCR_MSIZE_8BIT);
+		dma_set_priority(dma, dma_channel, DMA_CCR_PL_LOW);
+		dma_enable_transfer_complete_interrupt(dma, dma_channel);
+		i2c_enable_interrupt(i2c, I2C_CR2_ITERREN);
+	}
+
+	static bool send_command(uint8_t cmd)
+	{
+		return put(ControlCommand, cmd);
+	}
+
+	static bool send_data(uint8_t data)
+	{
+		return put(ControlData, data);
+	}
+
+	static void finish_send_data()
+	{
+		close_transaction();
+	}
+
+	// true if all queued commands and data are sent
+	static bool is_transfer_finished()
+	{
+		return !active_ && (rd_pos_ == committed_pos_) && (open_control_ == ControlNone);
+	}
+
+	// waits until all queued commands and data are sent
+	static bool wait_transfer_finished()
+	{
+		close_transaction();
+		return wait_idle();
+	}
+
+	static uint32_t get_errors_count()
+	{
+		return errors_count_;
+	}
+
+	/* interrupt handlers */
+
+	static void on_i2c_event()
+	{
+		uint32_t sr1 = I2C_SR1(i2c);
+
+		if (sr1 & I2C_SR1_SB)
+		{
+			i2c_send_7bit_address(i2c, addr/2, I2C_WRITE);
+		}
+		else if (sr1 & I2C_SR1_ADDR)
+		{
+			// DMA feeds data register, BTF is waited after DMA transfer complete
+			i2c_disable_interrupt(i2c, I2C_CR2_ITEVTEN);
+			i2c_enable_dma(i2c);
+			dma_enable_channel(dma, dma_channel);
+			I2C_SR2(i2c);
+		}
+		else if (sr1 & I2C_SR1_BTF)
+		{
+			i2c_disable_interrupt(i2c, I2C_CR2_ITEVTEN);
+			i2c_send_stop(i2c);
+			rd_pos_ = rd_pos_ + TransactionHeaderSize + read_len(rd_pos_);
+			wait_stop_sent();
+			start_next_transaction();
+		}
+	}
+
+	static void on_i2c_error()
+	{
+		I2C_SR1(i2c) &= ~(I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR | I2C_SR1_TIMEOUT);
+		i2c_send_stop(i2c);
+		abort_transfer();
+		errors_count_++;
+	}
+
+	static void on_dma_complete()
+	{
+		if (!dma_get_interrupt_flag(dma, dma_channel, DMA_TCIF)) return;
+		dma_clear_interrupt_flags(dma, dma_channel, DMA_TCIF);
+		dma_disable_channel(dma, dma_channel);
+		i2c_disable_dma(i2c);
+
+		// last byte is in shift register now
+		i2c_enable_interrupt(i2c, I2C_CR2_ITEVTEN);
+	}
+
+private:
+	static constexpr uint8_t ControlCommand = 0x00;
+	static constexpr uint8_t ControlData = 0x40;
+	static constexpr uint16_t ControlNone = 0xFFFF;
+	static constexpr unsigned TransactionHeaderSize = 2; // transaction length
+
+	/* Queue is linear buffer of transactions: [length (2 bytes)][control byte][payload].
+	   Writer appends transactions and commits them by committed_pos_,
+	   interrupts send them from rd_pos_. Queue is rewound to start when empty */
+
+	inline static uint8_t queue_[QueueSize] = {};
+	inline static unsigned wr_pos_ = 0;
+	inline static unsigned open_pos_ = 0;
+	inline static uint16_t open_control_ = ControlNone;
+	inline static volatile unsigned committed_pos_ = 0;
+	inline static volatile unsigned rd_pos_ = 0;
+	inline static volatile bool active_ = false;
+	inline static volatile uint32_t errors_count_ = 0;
+
+	static unsigned read_len(unsigned pos)
+	{
+		return queue_[pos] | (queue_[pos+1] << 8);
+	}
+
+	static bool put(uint8_t control, uint8_t value)
+	{
+		if (open_control_ != control)
+		{
+			close_transaction();
+			bool ok = open_transaction(control);
+			if (!ok) return false;
+		}
+		else if (wr_pos_ == QueueSize)
+		{
+			close_transaction();
+			bool ok = wait_idle() && open_transaction(control);
+			if (!ok) return false;
+		}
+
+		queue_[wr_pos_++] = value;
+
+		return true;
+	}
+
+	static void rewind()
+	{
+		rd_pos_ = 0;
+		committed_pos_ = 0;
+		wr_pos_ = 0;
+	}
+
+	static bool open_transaction(uint8_t control)
+	{
+		if (!active_ && (rd_pos_ == committed_pos_))
+			rewind();
+
+		if (QueueSize - wr_pos_ < TransactionHeaderSize + 2)
+		{
+			bool ok = wait_idle();
+			if (!ok) return false;
+			rewind();
+		}
+
+		open_pos_ = wr_pos_;
+		wr_pos_ += TransactionHeaderSize;
+		queue_[wr_pos_++] = control;
+		open_control_ = control;
+
+		return true;
+	}
+
+	static void close_transaction()
+	{
+		if (open_control_ == ControlNone) return;
+		open_control_ = ControlNone;
+
+		unsigned len = wr_pos_ - open_pos_ - TransactionHeaderSize;
+		if (len <= 1)
+		{
+			wr_pos_ = open_pos_;
+			return;
+		}
+
+		queue_[open_pos_] = len & 0xFF;
+		queue_[open_pos_+1] = len >> 8;
+
+		cm_disable_interrupts();
+		committed_pos_ = wr_pos_;
+		if (!active_) start_next_transaction();
+		cm_enable_interrupts();
+	}
+
+	static void start_next_transaction()
+	{
+		if (rd_pos_ == committed_pos_)
+		{
+			active_ = false;
+			return;
+		}
+
+		active_ = true;
+
+		dma_set_memory_address(dma, dma_channel, (uint32_t)&queue_[rd_pos_ + TransactionHeaderSize]);
+		dma_set_number_of_data(dma, dma_channel, read_len(rd_pos_));
+
+		i2c_enable_interrupt(i2c, I2C_CR2_ITEVTEN);
+		i2c_send_start(i2c);
+	}
+
+	static void wait_stop_sent()
+	{
+		// stop condition takes a few microseconds on the bus
+		uint32_t timer = time_out;
+		while (I2C_CR1(i2c) & I2C_CR1_STOP) if (timer && (--timer == 0)) return;
+	}
+
+	static void abort_transfer()
+	{
+		i2c_disable_interrupt(i2c, I2C_CR2_ITEVTEN);
+		dma_disable_channel(dma, dma_channel);
+		i2c_disable_dma(i2c);
+		rd_pos_ = committed_pos_;
+		active_ = false;
+	}
+
+	static bool wait_idle()
+	{
+		uint32_t timer = time_out;
+		while (active_)
+		{
+			if (timer && (--timer == 0))
+			{
+				cm_disable_interrupts();
+				i2c_send_stop(i2c);
+				abort_transfer();
+				errors_count_++;
+				cm_enable_interrupts();
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+} // namespace mgfxpp
@@ -151,9 +151,22 @@ static const uint8_t SYM_sad_smile[] = {6, 0x3C, 0x5A, 0x6E, 0x6E, 0x5A, 0x3C};
 
 static const Character font_5x8_data[] =
 {
-	{L' ', SYM_SPACE },
-	{L'?', SYM_QUEST},
-
+	{L' ', SYM_SPACE},
+	{L'!', SYM_S1},
+	{L'\"', SYM_S2},
+	{L'#', SYM_S4},
+	{L'$', SYM_S5},
+	{L'%', SYM_S6},
+	{L'&', SYM_S7},
+	{L'\'', SYM_S8},
+	{L'(', SYM_S9},
+	{L')', SYM_S10},
+	{L'*', SYM_S11},
+	{L'+', SYM_S12},
+	{L',', SYM_S13},
+	{L'-', SYM_S14},
+	{L'.', SYM_S15},
+	{L'/', SYM_S16},
 	{L'0', SYM_0},
 	{L'1', SYM_1},
 	{L'2', SYM_2},
@@ -164,170 +177,172 @@ static const Character font_5x8_data[] =
 	{L'7', SYM_7},
 	{L'8', SYM_8},
 	{L'9', SYM_9},
-
+	{L':', SYM_S18},
+	{L';', SYM_S19},
+	{L'<', SYM_S20},
+	{L'=', SYM_S22},
+	{L'>', SYM_S21},
+	{L'?', SYM_QUEST},
+	{L'@', SYM_S17},
 	{L'A', SYM_A},
-	{L'a', SYM_a},
 	{L'B', SYM_B},
-	{L'b', SYM_b},
 	{L'C', SYM_C},
-	{L'c', SYM_c},
 	{L'D', SYM_D},
-	{L'd', SYM_d},
 	{L'E', SYM_E},
-	{L'e', SYM_e},
 	{L'F', SYM_F},
-	{L'f', SYM_f},
 	{L'G', SYM_G},
-	{L'g', SYM_g},
 	{L'H', SYM_H},
-	{L'h', SYM_h},
 	{L'I', SYM_I},
-	{L'i', SYM_i},
 	{L'J', SYM_J},
-	{L'j', SYM_j},
 	{L'K', SYM_K},
-	{L'k', SYM_k},
 	{L'L', SYM_L},
-	{L'l', SYM_l},
 	{L'M', SYM_M},
-	{L'm', SYM_m},
 	{L'N', SYM_N},
-	{L'n', SYM_n},
 	{L'O', SYM_O},
-	{L'o', SYM_o},
 	{L'P', SYM_P},
-	{L'p', SYM_p},
 	{L'Q', SYM_Q},
-	{L'q', SYM_q},
 	{L'R', SYM_R},
-	{L'r', SYM_r},
 	{L'S', SYM_S},
-	{L's', SYM_s},
 	{L'T', SYM_T},
-	{L't', SYM_t},
 	{L'U', SYM_U},
-	{L'u', SYM_u},
 	{L'V', SYM_V},
-	{L'v', SYM_v},
 	{L'W', SYM_W},
-	{L'w', SYM_w},
 	{L'X', SYM_X},
-	{L'x', SYM_x},
 	{L'Y', SYM_Y},
-	{L'y', SYM_y},
 	{L'Z', SYM_Z},
+	{L'[', SYM_S23},
+	{L'\\', SYM_S3},
+	{L']', SYM_S24},
+	{L'^', SYM_S26},
+	{L'_', SYM_S25},
+
+	{L'a', SYM_a},
+	{L'b', SYM_b},
+	{L'c', SYM_c},
+	{L'd', SYM_d},
+	{L'e', SYM_e},
+	{L'f', SYM_f},
+	{L'g', SYM_g},
+	{L'h', SYM_h},
+	{L'i', SYM_i},
+	{L'j', SYM_j},
+	{L'k', SYM_k},
+	{L'l', SYM_l},
+	{L'm', SYM_m},
+	{L'n', SYM_n},
+	{L'o', SYM_o},
+	{L'p', SYM_p},
+	{L'q', SYM_q},
+	{L'r', SYM_r},
+	{L's', SYM_s},
+	{L't', SYM_t},
+	{L'u', SYM_u},
+	{L'v', SYM_v},
+	{L'w', SYM_w},
+	{L'x', SYM_x},
+	{L'y', SYM_y},
 	{L'z', SYM_z},
+	{L'{', SYM_S27},
+	{L'|', SYM_S29},
+	{L'}', SYM_S28},
+	{L'~', SYM_S30},
+
+	{L'µ', SYM_micro},
+
+	{L'Ё', SYM_YO},
 
 	{L'А', SYM_A},
-	{L'а', SYM_a},
 	{L'Б', SYM_BE},
-	{L'б', SYM_be},
 	{L'В', SYM_B},
-	{L'в', SYM_ve},
 	{L'Г', SYM_GE},
-	{L'г', SYM_ge},
 	{L'Д', SYM_DE},
-	{L'д', SYM_de},
 	{L'Е', SYM_E},
-	{L'е', SYM_e},
-	{L'Ё', SYM_YO},
-	{L'ё', SYM_yo},
 	{L'Ж', SYM_JE},
-	{L'ж', SYM_je},
 	{L'З', SYM_3},
-	{L'з', SYM_ze},
 	{L'И', SYM_YI},
-	{L'и', SYM_yi},
 	{L'Й', SYM_YY},
-	{L'й', SYM_YY},
 	{L'К', SYM_K},
-	{L'к', SYM_ke},
 	{L'Л', SYM_LE},
-	{L'л', SYM_le},
 	{L'М', SYM_M},
-	{L'м', SYM_me},
 	{L'Н', SYM_H},
-	{L'н', SYM_ne},
 	{L'О', SYM_O},
-	{L'о', SYM_o},
 	{L'П', SYM_PE},
-	{L'п', SYM_pe},
 	{L'Р', SYM_P},
-	{L'р', SYM_p},
 	{L'С', SYM_C},
-	{L'с', SYM_c},
 	{L'Т', SYM_T},
-	{L'т', SYM_te},
 	{L'У', SYM_UU},
-	{L'у', SYM_y},
 	{L'Ф', SYM_FE},
-	{L'ф', SYM_fe},
 	{L'Х', SYM_X},
-	{L'х', SYM_x},
 	{L'Ц', SYM_CE},
-	{L'ц', SYM_ce},
 	{L'Ч', SYM_CHE},
-	{L'ч', SYM_che},
 	{L'Ш', SYM_SHE},
-	{L'ш', SYM_she},
 	{L'Щ', SYM_SCHE},
-	{L'щ', SYM_sche},
 	{L'Ъ', SYM_TZ},
-	{L'ъ', SYM_tz},
 	{L'Ы', SYM_YII},
-	{L'ы', SYM_yii},
 	{L'Ь', SYM_b},
-	{L'ь', SYM_mz},
 	{L'Э', SYM_YEE},
-	{L'э', SYM_yee},
 	{L'Ю', SYM_YU},
-	{L'ю', SYM_yu},
 	{L'Я', SYM_YA},
+	{L'а', SYM_a},
+	{L'б', SYM_be},
+	{L'в', SYM_ve},
+	{L'г', SYM_ge},
+	{L'д', SYM_de},
+	{L'е', SYM_e},
+	{L'ж', SYM_je},
+	{L'з', SYM_ze},
+	{L'и', SYM_yi},
+	{L'й', SYM_YY},
+	{L'к', SYM_ke},
+	{L'л', SYM_le},
+	{L'м', SYM_me},
+	{L'н', SYM_ne},
+	{L'о', SYM_o},
+	{L'п', SYM_pe},
+	{L'р', SYM_p},
+	{L'с', SYM_c},
+	{L'т', SYM_te},
+	{L'у', SYM_y},
+	{L'ф', SYM_fe},
+	{L'х', SYM_x},
+	{L'ц', SYM_ce},
+	{L'ч', SYM_che},
+	{L'ш', SYM_she},
+	{L'щ', SYM_sche},
+	{L'ъ', SYM_tz},
+	{L'ы', SYM_yii},
+	{L'ь', SYM_mz},
+	{L'э', SYM_yee},
+	{L'ю', SYM_yu},
 	{L'я', SYM_ya},
 
-	{L'!', SYM_S1},
-	{L'\"', SYM_S2},
-	{L'\\', SYM_S3},
-	{L'#', SYM_S4},
-	{L'$', SYM_S5},
-	{L'%', SYM_S6},
-	{L'&', SYM_S7},
-	{L'\'', SYM_S8},
-	{L'(', SYM_S9},
-	{L')', SYM_S10},
-	{L'*', SYM_S11},
-	{L'+', SYM_S12},
-	{L',', SYM_S13},
-	{L'-', SYM_S14},
-	{L'.', SYM_S15},
-	{L'/', SYM_S16},
-	{L'@', SYM_S17},
-	{L':', SYM_S18},
-	{L';', SYM_S19},
-	{L'<', SYM_S20},
-	{L'>', SYM_S21},
-	{L'=', SYM_S22},
-	{L'[', SYM_S23},
-	{L']', SYM_S24},
-	{L'_', SYM_S25},
-	{L'^', SYM_S26},
-	{L'{', SYM_S27},
-	{L'}', SYM_S28},
-	{L'|', SYM_S29},
-	{L'~', SYM_S30},
+	{L'ё', SYM_yo},
 
-	{L'µ', SYM_micro},
 	{L'☹', SYM_sad_smile},
 
 	{0, nullptr}
 };
 
+static const CharRange font_5x8_ranges[] =
+{
+	// first code, count, index of first character
+	{32, 64, 0},
+	{97, 30, 64},
+	{181, 1, 94},
+	{1025, 1, 95},
+	{1040, 64, 96},
+	{1105, 1, 160},
+	{9785, 1, 161},
+};
+
 const Font font_simple8_ru = {
 	8,                           // height
-	FONT_FLAG_ONLY_BITMAP_WIDTH, // flags
+	FONT_FLAG_ONLY_BITMAP_WIDTH | FONT_FLAG_CHARS_SORTED | FONT_FLAG_CHARS_RANGES, // flags
 	1,                           // spacing
-	0,                           // character count
-	font_5x8_data                // characters data
+	162,                         // character count
+	font_5x8_data,               // characters data
+	7,                           // ranges count
+	font_5x8_ranges              // ranges of character codes
 };
 
 
@@ -44,6 +44,17 @@ enum class DisplayRotation
 
 using DrawFun = void (*) (const void *data);
 
+// Glyph bitmap in font layout: columns of vertical 8-pixel bytes, band by band
+struct DisplayGlyph
+{
+	const uint8_t* bitmap;
+	uint8_t bmp_width;
+	uint8_t bmp_height;
+	uint8_t bmp_top;
+	uint8_t width;  // cell width
+	uint8_t height; // cell height
+};
+
 // Display interface
 
 extern const DisplayRect& display_get_clip_rect();
@@ -53,6 +64,14 @@ extern void display_set_pixel(DispCrd x, DispCrd y, Color color);
 extern void display_fill_rect(const DisplayRect &rect, Color color);
 extern void display_draw(DrawFun fun, const void *data);
 
+// Draws glyph cell (opaque if bg isn't transparent) inside clip rect.
+// Returns false if display has no fast path for it and caller must draw by pixels
+extern bool display_draw_glyph(DispCrd x, DispCrd y, const DisplayGlyph &glyph, Color fg, Color bg);
+
+// True if display has display_draw_glyph() fast path. Text is drawn on such
+// display cell by cell opaque, other displays get text background by fill_rect
+extern bool display_has_draw_glyph();
+
 template <typename Fun>
 void display_draw(const Fun &fun)
 {
@@ -248,6 +267,7 @@ class MonoBufferedDisplay
 public:
 	static constexpr unsigned width = Display::get_width();
 	static constexpr unsigned height = Display::get_height();
+	static constexpr bool has_draw_glyph = true;
 
 	static void set_pixel(DispCrd x, DispCrd y, Color value)
 	{
@@ -285,9 +305,9 @@ public:
 		const unsigned offset = xx + (yy / 8) * width;
 		while (offset >= BufferSize) {} // assert
 
-		PixelBlock* const pixel_data_ptr = data_ + offset;
+		uint8_t* const pixel_data_ptr = data_ + offset;
 		const uint8_t mask = 1 << (yy & 0x7);
-		uint8_t pixel_data = pixel_data_ptr->data;
+		uint8_t pixel_data = *pixel_data_ptr;
 
 		switch (mono_color_to_bw_display_color(value, xx, yy))
 		{
@@ -308,11 +328,171 @@ public:
 			return;
 		}
 
-		if (pixel_data != pixel_data_ptr->data)
+		if (pixel_data != *pixel_data_ptr)
+		{
+			*pixel_data_ptr = pixel_data;
+			mark_dirty(yy / 8, xx, xx);
+		}
+	}
+
+	static void fill_rect(const DisplayRect &rect, Color value)
+	{
+		if (value == Color::Tansparent) return;
+
+		DisplayRect clipped = rect;
+		if (clipped.right >= get_width()) clipped.right = get_width() - 1;
+		if (clipped.bottom >= get_height()) clipped.bottom = get_height() - 1;
+		if ((clipped.left > clipped.right) || (clipped.top > clipped.bottom)) return;
+
+		// rect in display buffer coordinates
+		DispCrd x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+
+		switch (rot_)
+		{
+		case DisplayRotation::NS:
+			x1 = clipped.left;
+			x2 = clipped.right;
+			y1 = clipped.top;
+			y2 = clipped.bottom;
+			break;
+
+		case DisplayRotation::SN:
+			x1 = width - clipped.right - 1;
+			x2 = width - clipped.left - 1;
+			y1 = height - clipped.bottom - 1;
+			y2 = height - clipped.top - 1;
+			break;
+
+		case DisplayRotation::EW:
+			x1 = width - clipped.bottom - 1;
+			x2 = width - clipped.top - 1;
+			y1 = clipped.left;
+			y2 = clipped.right;
+			break;
+
+		case DisplayRotation::WE:
+			x1 = clipped.top;
+			x2 = clipped.bottom;
+			y1 = height - clipped.right - 1;
+			y2 = height - clipped.left - 1;
+			break;
+		}
+
+		const bool is_pattern =
+			(value == Color::DarkGray) ||
+			(value == Color::Gray) ||
+			(value == Color::LiteGray);
+
+		const BwDisplayColor bw_color = mono_color_to_bw_display_color(value, 0, 0);
+
+		for (unsigned page = y1 / 8; page <= y2 / 8; page++)
+		{
+			const unsigned first_bit = (page == y1 / 8) ? (y1 & 7) : 0;
+			const unsigned last_bit = (page == y2 / 8) ? (y2 & 7) : 7;
+			const uint8_t mask = (0xFF << first_bit) & (0xFF >> (7 - last_bit));
+
+			uint8_t* const page_data = data_ + page * width;
+			unsigned first_changed = width;
+			unsigned last_changed = 0;
+
+			for (unsigned x = x1; x <= x2; x++)
+			{
+				uint8_t pixel_data = page_data[x];
+
+				if (is_pattern)
+					pixel_data = (pixel_data & ~mask) | (get_pattern_byte(value, x) & mask);
+				else if (bw_color == BwDisplayColor::Set)
+					pixel_data |= mask;
+				else if (bw_color == BwDisplayColor::Clear)
+					pixel_data &= ~mask;
+				else
+					pixel_data ^= mask;
+
+				if (pixel_data != page_data[x])
+				{
+					page_data[x] = pixel_data;
+					if (first_changed == width) first_changed = x;
+					last_changed = x;
+				}
+			}
+
+			if (first_changed != width)
+				mark_dirty(page, first_changed, last_changed);
+		}
+	}
+
+	// Glyph columns are shifted into page bytes directly. Only not rotated
+	// display and solid colors are supported
+	static bool draw_glyph(DispCrd x, DispCrd y, const DisplayGlyph &glyph, Color fg, Color bg)
+	{
+		if (rot_ != DisplayRotation::NS) return false;
+		if ((fg != Color::PixelOn) && (fg != Color::PixelOff)) return false;
+		if ((bg != Color::PixelOn) && (bg != Color::PixelOff) && (bg != Color::Tansparent)) return false;
+
+		const unsigned shift = y & 7;
+		if (glyph.height + shift >= 64) return false;
+		if (glyph.bmp_top + glyph.bmp_height > glyph.height) return false;
+		if ((x + glyph.width > width) || (y + glyph.height > height)) return false;
+
+		const bool fg_set = (fg == Color::PixelOn);
+		const bool bg_opaque = (bg != Color::Tansparent);
+		const bool bg_set = (bg == Color::PixelOn);
+
+		const uint64_t cell_mask = (((uint64_t)1 << glyph.height) - 1) << shift;
+		const unsigned bands = (glyph.bmp_height + 7) / 8;
+		const uint64_t bmp_mask = (((uint64_t)1 << glyph.bmp_height) - 1);
+		const unsigned first_page = y / 8;
+		const unsigned last_page = (y + glyph.height - 1) / 8;
+
+		unsigned first_changed[PagesCount];
+		unsigned last_changed[PagesCount];
+		for (unsigned page = first_page; page <= last_page; page++)
+			first_changed[page] = width;
+
+		for (unsigned j = 0; j < glyph.width; j++)
 		{
-			pixel_data_ptr->data = pixel_data;
-			is_changed_ = true;
+			uint64_t column = 0;
+			if (j < glyph.bmp_width)
+			{
+				for (unsigned band = 0; band < bands; band++)
+					column |= (uint64_t)glyph.bitmap[band * glyph.bmp_width + j] << (8 * band);
+				column = (column & bmp_mask) << (glyph.bmp_top + shift);
+			}
+
+			const unsigned xx = x + j;
+			for (unsigned page = first_page; page <= last_page; page++)
+			{
+				const unsigned bit_pos = 8 * (page - first_page);
+				const uint8_t mask = cell_mask >> bit_pos;
+				const uint8_t glyph_bits = column >> bit_pos;
+
+				uint8_t &dst = data_[page * width + xx];
+				uint8_t value = dst;
+
+				if (fg_set) value |= glyph_bits;
+				else value &= ~glyph_bits;
+
+				if (bg_opaque)
+				{
+					const uint8_t bg_bits = mask & ~glyph_bits;
+					if (bg_set) value |= bg_bits;
+					else value &= ~bg_bits;
+				}
+
+				if (value != dst)
+				{
+					dst = value;
+					if (first_changed[page] == width) first_changed[page] = xx;
+					last_changed[page] = xx;
+				}
+			}
 		}
+
+		for (unsigned page = first_page; page <= last_page; page++)
+			if (first_changed[page] != width)
+				mark_dirty(page, first_changed[page], last_changed[page]);
+
+		return true;
 	}
 
 	static DispCrd get_width()
@@ -350,48 +530,66 @@ public:
 	}
 
 private:
-	struct PixelBlock
+	static constexpr unsigned PagesCount = (height + 7) / 8;
+	static constexpr unsigned BufferSize = width * PagesCount;
+
+	// changed columns of page [first, end). Empty if end is 0
+	struct DirtySpan
 	{
-		uint8_t data;
-		uint8_t prev;
+		uint16_t first;
+		uint16_t end;
 	};
 
-	static constexpr unsigned BufferSize = width * ((height + 7) / 8);
-
-	inline static PixelBlock data_[BufferSize] = {};
+	inline static uint8_t data_[BufferSize] = {};
+	inline static DirtySpan dirty_[PagesCount] = {};
 	inline static bool is_changed_ = false;
 	inline static bool first_time_ = true;
 	inline static DisplayRect clip_rect_ = DisplayRect{0, 0, width - 1, height - 1};
 	inline static DisplayRotation rot_ = DisplayRotation::NS;
 
+	static void mark_dirty(unsigned page, unsigned first_col, unsigned last_col)
+	{
+		DirtySpan &span = dirty_[page];
+		if (span.end == 0)
+		{
+			span.first = first_col;
+			span.end = last_col + 1;
+		}
+		else
+		{
+			if (first_col < span.first) span.first = first_col;
+			if (last_col >= span.end) span.end = last_col + 1;
+		}
+		is_changed_ = true;
+	}
+
+	// Byte of page at column x filled with dither pattern. All patterns
+	// repeat every 2 pixels vertically so byte doesn't depend on page
+	static uint8_t get_pattern_byte(Color value, unsigned x)
+	{
+		uint8_t result = 0;
+		for (unsigned k = 0; k < 8; k++)
+			if (mono_color_to_bw_display_color(value, x, k) == BwDisplayColor::Set)
+				result |= 1 << k;
+		return result;
+	}
+
 	static void write_to_display()
 	{
 		if (!is_changed_ && !first_time_) return;
 
-		auto *data = data_;
-		for (unsigned y = 0; y < (height + 7) / 8; y++)
+		for (unsigned page = 0; page < PagesCount; page++)
 		{
-			bool y_changed = true;
-			unsigned disp_x = width;
-			uint8_t last_change_counter = 0;
-			for (unsigned x = 0; x < width; x++)
-			{
-				if ((data->data != data->prev) || first_time_ || (last_change_counter != 0))
-				{
-					if ((x != disp_x) || y_changed)
-					{
-						Display::set_pos(x, y);
-						last_change_counter = 25;
-						y_changed = false;
-					}
-					Display::write_data(data->data);
-					data->prev = data->data;
-					disp_x = x + 1;
-				};
-				data++;
-				if (last_change_counter)
-					--last_change_counter;
-			}
+			DirtySpan &span = dirty_[page];
+			if (first_time_) span = { 0, width };
+			if (span.end == 0) continue;
+
+			Display::set_pos(span.first, page);
+			const uint8_t *data = data_ + page * width;
+			for (unsigned x = span.first; x < span.end; x++)
+				Display::write_data(data[x]);
+
+			span = {};
 		}
 
 		Display::flush();
@@ -441,6 +639,17 @@ void mgfxpp::display_fill_rect(const DisplayRect &rect, Color color) \
 void mgfxpp::display_draw(DrawFun fun, const void *data)             \
 {                                                                    \
 	fun(data);                                                       \
+}                                                                    \
+                                                                     \
+bool mgfxpp::display_draw_glyph(DispCrd, DispCrd,                    \
+	const DisplayGlyph&, Color, Color)                               \
+{                                                                    \
+	return false;                                                    \
+}                                                                    \
+                                                                     \
+bool mgfxpp::display_has_draw_glyph()                                \
+{                                                                    \
+	return false;                                                    \
 }
 
 
@@ -472,7 +681,7 @@ void display_set_pixel(DispCrd x, DispCrd y, Color color)    \
                                                              \
 void display_fill_rect(const DisplayRect &rect, Color color) \
 {                                                            \
-	display_fill_rect_default(rect, color);                  \
+	BUFFER::fill_rect(rect, color);                          \
 }                                                            \
                                                              \
 void display_draw(DrawFun fun, const void *data)             \
@@ -480,4 +689,15 @@ void display_draw(DrawFun fun, const void *data)             \
 	BUFFER::draw(fun, data);                                 \
 }                                                            \
                                                              \
+bool display_draw_glyph(DispCrd x, DispCrd y,                \
+	const DisplayGlyph &glyph, Color fg, Color bg)           \
+{                                                            \
+	return BUFFER::draw_glyph(x, y, glyph, fg, bg);          \
+}                                                            \
+                                                             \
+bool display_has_draw_glyph()                                \
+{                                                            \
+	return BUFFER::has_draw_glyph;                           \
+}                                                            \
+                                                             \
 } // namespace mgfxpp
@@ -506,7 +506,7 @@ static void fill_ellipse_impl(Crd left, Crd top, Crd right, Crd bottom)
 		if (!x1_defined) continue;
 
 		if (x2 == -1)
-			x2 = right-1;
+			x2 = min(right-1, right_lim);
 
 		fill_rect_impl(DisplayRect(x1, y, x2, y));
 	}
@@ -667,7 +667,34 @@ static Crd cur_text_x = 0;
 static Crd cur_text_y = 0;
 static const Font* cur_font = nullptr;
 
-static void print_symbol(const SymbolData& symbol, const DisplayRect &clip_rect)
+// Text cells are drawn opaque on display with glyph fast path, so redrawing
+// of the same text doesn't change display buffer. On other displays text
+// background is filled by one fill_rect and only glyph pixels are drawn
+static bool text_cells_opaque = false;
+
+static bool print_symbol_fast(const SymbolData& symbol, unsigned width, const DisplayRect &clip_rect)
+{
+#if defined(MGFXPP_MONO)
+	const unsigned height = cur_font->height;
+	if ((cur_text_x < (Crd)clip_rect.left) || (cur_text_y < (Crd)clip_rect.top)) return false;
+	if ((cur_text_x + width - 1 > clip_rect.right) || (cur_text_y + height - 1 > clip_rect.bottom)) return false;
+
+	const DisplayGlyph glyph {
+		symbol.bitmap,
+		symbol.bmp_width,
+		symbol.bmp_height,
+		symbol.bmp_top,
+		(uint8_t)width,
+		(uint8_t)height
+	};
+
+	return display_draw_glyph(cur_text_x, cur_text_y, glyph, fg, bg);
+#else
+	return false;
+#endif
+}
+
+static void print_symbol_transparent(const SymbolData& symbol, const DisplayRect &clip_rect)
 {
 	unsigned y_cnt = (symbol.bmp_height + 7) / 8;
 
@@ -694,13 +721,62 @@ static void print_symbol(const SymbolData& symbol, const DisplayRect &clip_rect)
 	}
 }
 
-static void print_char(uint32_t chr, const DisplayRect &clip_rect)
+static void print_symbol(const SymbolData& symbol, const DisplayRect &clip_rect)
 {
-	if (cur_font == nullptr) return;
+	if (!text_cells_opaque)
+	{
+		print_symbol_transparent(symbol, clip_rect);
+		return;
+	}
+
+	if (print_symbol_fast(symbol, symbol.width - symbol.spacing, clip_rect)) return;
+
+	// cell isn't supported by fast path (clipped or rotated display)
 
-	auto* font_chr = font_find_charaster(*cur_font, chr);
-	if (!font_chr) return;
+	const unsigned bmp_bottom = symbol.bmp_top + symbol.bmp_height;
+	const unsigned glyph_width = symbol.width - symbol.spacing;
+	const unsigned height = max<unsigned>(cur_font->height, bmp_bottom);
+
+	for (unsigned j = 0; j < glyph_width; j++)
+	{
+		for (unsigned y = 0; y < height; y++)
+		{
+			bool is_set = false;
+			if ((j < symbol.bmp_width) && (y >= symbol.bmp_top) && (y < bmp_bottom))
+			{
+				unsigned bmp_y = y - symbol.bmp_top;
+				is_set = symbol.bitmap[(bmp_y / 8) * symbol.bmp_width + j] & (1 << (bmp_y % 8));
+			}
 
+			if (is_set)
+				set_fg_pixel(cur_text_x + j, cur_text_y + y, clip_rect);
+			else
+				set_bg_pixel(cur_text_x + j, cur_text_y + y, clip_rect);
+		}
+	}
+}
+
+static void print_spacing(unsigned spacing, const DisplayRect &clip_rect)
+{
+	if (spacing == 0) return;
+
+	if (!text_cells_opaque || print_symbol_fast(SymbolData{}, spacing, clip_rect))
+	{
+		cur_text_x += spacing;
+		return;
+	}
+
+	for (unsigned j = 0; j < spacing; j++)
+		for (unsigned y = 0; y < cur_font->height; y++)
+			set_bg_pixel(cur_text_x + j, cur_text_y + y, clip_rect);
+
+	cur_text_x += spacing;
+}
+
+// Returns spacing after char. Spacing is drawn before next char only
+// to not draw background after last char of text
+static unsigned print_char(const Character* font_chr, const DisplayRect &clip_rect)
+{
 	SymbolData symbol_data;
 
 	font_get_symbol_data(*cur_font, font_chr, symbol_data);
@@ -715,7 +791,9 @@ static void print_char(uint32_t chr, const DisplayRect &clip_rect)
 	if (is_rect_visible(char_rect, clip_rect))
 		print_symbol(symbol_data, clip_rect);
 
-	cur_text_x += symbol_data.width;
+	cur_text_x += symbol_data.width - symbol_data.spacing;
+
+	return symbol_data.spacing;
 }
 
 struct DisplayCharDest : CharDest
@@ -724,12 +802,88 @@ struct DisplayCharDest : CharDest
 		clip_rect(clip_rect)
 	{}
 
+	~DisplayCharDest()
+	{
+		cur_text_x += spacing_;
+	}
+
 	void consume(Char chr) override
 	{
-		print_char(chr, clip_rect);
+		print_spacing(spacing_, clip_rect);
+		spacing_ = 0;
+
+		if (cur_font == nullptr) return;
+
+		auto* font_chr = font_find_charaster(*cur_font, chr);
+		if (!font_chr) return;
+
+		spacing_ = print_char(font_chr, clip_rect);
+	}
+
+	void consume_font_char(const Character* font_chr)
+	{
+		print_spacing(spacing_, clip_rect);
+		spacing_ = print_char(font_chr, clip_rect);
 	}
 
 	const DisplayRect &clip_rect;
+
+private:
+	unsigned spacing_ = 0;
+};
+
+/* Text layout made by one run of char source: found font characters
+   are cached with text width, so text is measured and drawn without
+   producing it again. Source is produced second time only if text is
+   longer than cache */
+
+struct TextRunCharDest : CharDest
+{
+	void consume(Char chr) override
+	{
+		if (cur_font == nullptr) return;
+
+		auto* font_char = font_find_charaster(*cur_font, chr);
+		if (!font_char) return;
+
+		SymbolData symbol_data;
+		font_get_symbol_data(*cur_font, font_char, symbol_data);
+		width_ += symbol_data.width;
+		last_spacing_ = symbol_data.spacing;
+
+		if (count_ < MaxCount)
+			chars_[count_++] = font_char;
+		else
+			is_overflow_ = true;
+	}
+
+	uint32_t get_width() const
+	{
+		return width_ - last_spacing_;
+	}
+
+	void draw(CharSource& src, const DisplayRect &clip_rect) const
+	{
+		DisplayCharDest display { clip_rect };
+
+		if (is_overflow_)
+		{
+			src.produce(display);
+			return;
+		}
+
+		for (unsigned i = 0; i < count_; i++)
+			display.consume_font_char(chars_[i]);
+	}
+
+private:
+	static constexpr unsigned MaxCount = 32;
+
+	const Character* chars_[MaxCount];
+	unsigned count_ = 0;
+	bool is_overflow_ = false;
+	uint32_t width_ = 0;
+	uint8_t last_spacing_ = 0;
 };
 
 struct CalcWidthCharDest : CharDest
@@ -781,7 +935,10 @@ void get_text_draw_pos(Crd* x, Crd* y)
 
 void draw_any_text_impl(CharSource& src)
 {
-	int text_width = get_any_text_width(src);
+	TextRunCharDest run;
+	src.produce(run);
+
+	int text_width = run.get_width();
 	if (text_width == 0) return;
 
 	Rect rect {
@@ -795,10 +952,12 @@ void draw_any_text_impl(CharSource& src)
 	if (!is_rect_visible(rect, disp_clip_rect)) return;
 
 	before_draw_figure(rect);
-	fill_rect_impl(get_visible_rect(rect, disp_clip_rect));
 
-	DisplayCharDest display { disp_clip_rect };
-	src.produce(display);
+	text_cells_opaque = display_has_draw_glyph();
+	if (!text_cells_opaque)
+		fill_rect_impl(get_visible_rect(rect, disp_clip_rect));
+
+	run.draw(src, disp_clip_rect);
 }
 
 void draw_any_text_rect_impl(const Rect& rect, HorizAlign h_align, Crd h_padding, CharSource& any)
@@ -813,6 +972,9 @@ void draw_any_text_rect_impl(const Rect& rect, HorizAlign h_align, Crd h_padding
 
 	fill_rect(rect);
 
+	TextRunCharDest run;
+	any.produce(run);
+
 	switch (h_align)
 	{
 	case HorizAlign::Left:
@@ -820,18 +982,19 @@ void draw_any_text_rect_impl(const Rect& rect, HorizAlign h_align, Crd h_padding
 		break;
 
 	case HorizAlign::Center:
-		x = (rect.left + rect.right - (int)get_any_text_width(any) + 1) / 2;
+		x = (rect.left + rect.right - (int)run.get_width() + 1) / 2;
 		if (x < rect.left) x = rect.left;
 		break;
 
 	case HorizAlign::Right:
-		x = rect.right - (int)get_any_text_width(any) - h_padding;
+		x = rect.right - (int)run.get_width() - h_padding;
 		break;
 	}
 
-	DisplayCharDest display { disp_clip_rect };
+	// background of whole rect is filled already
+	text_cells_opaque = false;
 	set_text_draw_pos(x, y);
-	any.produce(display);
+	run.draw(any, disp_clip_rect);
 }
 
 void draw_any_text(CharSource& src)
@@ -6,7 +6,17 @@ namespace mgfxpp {
 
 const Character* font_find_charaster(const Font& font, uint32_t char_code)
 {
-	if (font.flags & FONT_FLAG_CHARS_SORTED)
+	if (font.flags & FONT_FLAG_CHARS_RANGES)
+	{
+		for (unsigned i = 0; i < font.range_count; i++)
+		{
+			const CharRange& range = font.ranges[i];
+			uint32_t offset = char_code - range.first_code;
+			if (offset < range.count)
+				return font.characters + range.first_index + offset;
+		}
+	}
+	else if (font.flags & FONT_FLAG_CHARS_SORTED)
 	{
 		const Character* begin = font.characters;
 		const Character* end = font.characters + font.charaster_count - 1;
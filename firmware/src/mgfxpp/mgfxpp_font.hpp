@@ -10,8 +10,17 @@ struct Character
 	const uint8_t *data;
 };
 
+// Range of consecutive character codes stored one after another in characters
+struct CharRange
+{
+	uint32_t first_code;
+	uint16_t count;
+	uint16_t first_index;
+};
+
 constexpr uint8_t FONT_FLAG_ONLY_BITMAP_WIDTH = 1;
 constexpr uint8_t FONT_FLAG_CHARS_SORTED      = 2;
+constexpr uint8_t FONT_FLAG_CHARS_RANGES      = 4; // character is found by index in range
 
 struct Font
 {
@@ -20,6 +29,8 @@ struct Font
 	uint8_t spacing;
 	uint16_t charaster_count;
 	const Character* characters;
+	uint8_t range_count;
+	const CharRange* ranges;
 };
 
 const Character* font_find_charaster(const Font &font, uint32_t char_code);
@@ -59,7 +59,7 @@ struct PrintfSource : CharSource
 	{
 		bool wide_char_callback(void* data, mf::WideChar character);
 		mf::impl::Utf8Receiver utf8_rec { wide_char_callback, &destination, 0, 0, '?', 0 };
-		mf::impl::FormatCtx ctx { { mf::impl::utf8_char_callback, &utf8_rec, 0 }, args_arr_, sizeof ... (Args) };
+		mf::impl::FormatCtx ctx { { nullptr, &utf8_rec, 0, mf::impl::utf8_text_callback }, args_arr_, sizeof ... (Args) };
 		mf::impl::format_impl(ctx, format_utf8_);
 		printf_result_ = utf8_rec.chars_printed;
 	}
@@ -37,82 +37,53 @@ namespace impl {
 #define MODF modff
 #endif
 
-#if defined (MICRO_FORMAT_INT64)
-	using UIntType = unsigned long long;
-	using IntType = long long;
-#else
-	using UIntType = unsigned long;
-	using IntType = long;
-#endif
-
-struct FormatSpecFlags
-{
-	uint8_t octothorp : 1;
-	uint8_t upper_case : 1;
-	uint8_t zero : 1;
-	uint8_t parsed_ok : 1;
-};
-
-struct FormatSpec
+static void put_char(DstData& dst, char chr)
 {
-	int width = -1;
-	int precision = -1;
-	int length = -1;
-	int index = -1;
-	FormatSpecFlags flags{};
-	char align = 0; // '<', '^', '>'
-	char sign = 0;  // '+', '-', ' '
-	char format = 0;
-};
+	if (dst.text_callback)
+	{
+		dst.chars_printed += dst.text_callback(dst.data, &chr, 1);
+		return;
+	}
 
-static bool is_integer_arg_type(FormatArgType arg_type)
-{
-	return
-		(arg_type == FormatArgType::Short) ||
-		(arg_type == FormatArgType::UShort) ||
-		(arg_type == FormatArgType::Int) ||
-		(arg_type == FormatArgType::UInt) ||
-		(arg_type == FormatArgType::Long) ||
-		(arg_type == FormatArgType::ULong);
+	bool char_is_printed = dst.callback(dst.data, chr);
+	if (char_is_printed)
+		++dst.chars_printed;
 }
 
-static bool is_float_arg_type(FormatArgType arg_type)
+static void put_text(DstData& dst, const char* text, size_t len)
 {
-	return
-		(arg_type == FormatArgType::Float) ||
-		(arg_type == FormatArgType::Double);
-}
+	if (len == 0) return;
 
-static bool is_char_arg_type(FormatArgType arg_type)
-{
-	return
-		(arg_type == FormatArgType::Char);
-}
+	if (dst.text_callback)
+	{
+		dst.chars_printed += dst.text_callback(dst.data, text, len);
+		return;
+	}
 
-static bool is_bool_arg_type(FormatArgType arg_type)
-{
-	return
-		(arg_type == FormatArgType::Bool);
+	while (len--)
+		put_char(dst, *text++);
 }
 
-static bool is_str_arg_type(FormatArgType arg_type)
+static void put_fill(DstData& dst, char chr, int count)
 {
-	return
-		(arg_type == FormatArgType::CharPtr);
-}
+	static const char spaces[] = "                ";
+	static const char zeros[] = "0000000000000000";
+	constexpr int chunk_size = sizeof(spaces) - 1;
 
-
-static void put_char(DstData& dst, char chr)
-{
-	bool char_is_printed = dst.callback(dst.data, chr);
-	if (char_is_printed)
-		++dst.chars_printed;
+	const char* fill = (chr == '0') ? zeros : spaces;
+	while (count > 0)
+	{
+		int len = (count < chunk_size) ? count : chunk_size;
+		put_text(dst, fill, len);
+		count -= len;
+	}
 }
 
 static void print_raw_string(DstData& dst, const char *text)
 {
-	while (*text)
-		put_char(dst, *text++);
+	const char* end = text;
+	while (*end) end++;
+	put_text(dst, text, end - text);
 }
 
 static void print_error(FormatCtx& ctx)
@@ -128,193 +99,6 @@ static int strlen(const char *str)
 	return result;
 }
 
-static const char* get_format_specifier(const char* format_str, FormatSpec& format_spec, int index)
-{
-	enum class State : uint8_t
-	{
-		Undef,
-		IndexSpecified,
-		PtPassed,
-		PrecSpecified,
-		FormatSpecified,
-		Finished
-	};
-
-	State state = State::Undef;
-
-	const char* orig_format_str = format_str;
-
-	int* int_value = &format_spec.index;
-
-	for (;;)
-	{
-		unsigned char chr = (unsigned char)*format_str++;
-
-		if ((chr >= '0') && (chr <= '9'))
-		{
-			if ((state >= State::IndexSpecified) &&
-				(state < State::PtPassed) &&
-				(chr == '0') &&
-				(*int_value == -1))
-			{
-				format_spec.flags.zero = true;
-				continue;
-			}
-			else if (int_value)
-			{
-				if (*int_value == -1) *int_value = 0;
-				*int_value *= 10;
-				*int_value += chr - '0';
-				continue;
-			}
-			else
-				return orig_format_str;
-		}
-		else if (int_value && (*int_value != -1))
-			int_value = nullptr;
-
-		switch (chr)
-		{
-		case ':':
-			if (state == State::Undef)
-			{
-				int_value = &format_spec.width;
-				state = State::IndexSpecified;
-			}
-			else
-				return orig_format_str;
-			break;
-
-		case '.':
-			if ((state >= State::IndexSpecified) && (state < State::PtPassed))
-			{
-				int_value = &format_spec.precision;
-				state = State::PtPassed;
-			}
-			else
-				return orig_format_str;
-			break;
-
-		case '<': case '>': case '^':
-			if (format_spec.align == 0)
-				format_spec.align = chr;
-			else
-				return orig_format_str;
-			break;
-
-		case '+': case '-': case ' ':
-			if (format_spec.sign == 0)
-				format_spec.sign = chr;
-			else
-				return orig_format_str;
-			break;
-
-		case '#':
-			format_spec.flags.octothorp = true;
-			break;
-
-		case 'B': case 'b': case 'd':
-		case 'o': case 'x': case 'X':
-		case 'c': case 'f': case 'F':
-		case 's':
-			if (format_spec.format == 0)
-				format_spec.format = chr;
-			else
-				return orig_format_str;
-			state = State::FormatSpecified;
-			break;
-
-		case '}':
-			state = State::Finished;
-			break;
-
-		default:
-			return orig_format_str;
-		}
-
-		if (state == State::Finished) break;
-	}
-
-	auto user_format = format_spec.format;
-	switch (format_spec.format)
-	{
-	case 'F': format_spec.format = 'f'; break;
-	case 'X': format_spec.format = 'x'; break;
-	case 'B': format_spec.format = 'b'; break;
-	}
-	format_spec.flags.upper_case = (user_format != format_spec.format);
-
-	format_spec.flags.parsed_ok = true;
-
-	if (format_spec.index == -1)
-		format_spec.index = index;
-
-	return format_str;
-}
-
-static bool check_format_specifier(FormatCtx& ctx, FormatSpec& format_spec)
-{
-	if (format_spec.index >= ctx.args_count) return false;
-
-	auto type = ctx.args[format_spec.index].type;
-	auto f = format_spec.format;
-
-	if (is_float_arg_type(type) && (f != 'f') && (f != 0))
-		return false;
-
-	bool is_integer_presentation =
-		(f == 'b') || (f == 'd') || (f == 'o') || (f == 'x');
-
-	if ((is_integer_arg_type(type) || is_char_arg_type(type)) &&
-	    !is_integer_presentation && (f != 'c') && (f != 0))
-		return false;
-
-	if (is_bool_arg_type(type) && !is_integer_presentation && (f != 's') && (f != 0))
-		return false;
-
-	if (is_str_arg_type(type) && (f != 's') && (f != 0))
-		return false;
-
-	return true;
-}
-
-static void correct_format_specifier(FormatCtx& ctx, FormatSpec& format_spec)
-{
-	auto arg_type = ctx.args[format_spec.index].type;
-
-	if (format_spec.align == 0)
-	{
-		if (is_integer_arg_type(arg_type) || is_float_arg_type(arg_type))
-			format_spec.align = '>';
-		else
-			format_spec.align = '<';
-	}
-
-	switch (arg_type)
-	{
-	case FormatArgType::Pointer:
-		if (format_spec.format == 0)
-		{
-			format_spec.format = 'p';
-			format_spec.flags.zero = true;
-			format_spec.flags.octothorp = true;
-
-			if (format_spec.width == -1)
-				format_spec.width = 2 * sizeof(void*) + (format_spec.flags.octothorp ? 2 : 0);
-		}
-		break;
-
-	case FormatArgType::Float:
-	case FormatArgType::Double:
-		if (format_spec.precision == -1)
-			format_spec.precision = 6;
-		break;
-
-	default:
-		break;
-	}
-}
-
 static void print_presentation(FormatCtx& ctx, const FormatSpec& format_spec)
 {
 	if (!format_spec.flags.octothorp) return;
@@ -364,8 +148,7 @@ static void print_leading_spaces(FormatCtx& ctx, const FormatSpec& format_spec,
 		chars_count = (format_spec.width - len) / 2;
 	}
 
-	while (chars_count--)
-		put_char(ctx.dst, char_to_print);
+	put_fill(ctx.dst, char_to_print, chars_count);
 }
 
 static void print_trailing_spaces(FormatCtx& ctx, const FormatSpec& format_spec, int len)
@@ -380,13 +163,15 @@ static void print_trailing_spaces(FormatCtx& ctx, const FormatSpec& format_spec,
 	else if (format_spec.align == '^')
 		chars_count = (format_spec.width - len + 1) / 2;
 
-	while (chars_count--)
-		put_char(ctx.dst, ' ');
+	put_fill(ctx.dst, ' ', chars_count);
 }
 
 static void print_sign_and_leading_spaces(FormatCtx& ctx, const FormatSpec& format_spec, bool is_negative, int len, bool ignore_zero_flag)
 {
-	if (format_spec.flags.zero)
+	// sign goes before zeros but after spaces
+	bool zero_padding = format_spec.flags.zero && !ignore_zero_flag;
+
+	if (zero_padding)
 	{
 		print_sign(ctx, format_spec, is_negative);
 		print_presentation(ctx, format_spec);
@@ -394,7 +179,7 @@ static void print_sign_and_leading_spaces(FormatCtx& ctx, const FormatSpec& form
 
 	print_leading_spaces(ctx, format_spec, len, ignore_zero_flag);
 
-	if (!format_spec.flags.zero)
+	if (!zero_padding)
 	{
 		print_sign(ctx, format_spec, is_negative);
 		print_presentation(ctx, format_spec);
@@ -418,17 +203,23 @@ static void print_char_impl(FormatCtx& ctx, const FormatSpec& format_spec, char
 
 static void print_uint_impl(DstData& dst, UIntType value, unsigned base, bool upper_case)
 {
-	if (value >= base)
-		print_uint_impl(dst, value / base, base, upper_case);
+	// digits are made from the end and printed by one call
+	char buffer[sizeof(UIntType) * 8];
+	char* end = buffer + sizeof(buffer);
+	char* begin = end;
 
-	unsigned value_to_print = value % base;
+	do
+	{
+		unsigned value_to_print = value % base;
+		value /= base;
 
-	char char_to_print =
-		(value_to_print < 10)
-		? (value_to_print + '0')
-		: (value_to_print - 10 + (upper_case ? 'A' : 'a'));
+		*--begin =
+			(value_to_print < 10)
+			? (value_to_print + '0')
+			: (value_to_print - 10 + (upper_case ? 'A' : 'a'));
+	} while (value != 0);
 
-	put_char(dst, char_to_print);
+	put_text(dst, begin, end - begin);
 }
 
 static int find_uint_len(UIntType value, unsigned base)
@@ -441,6 +232,15 @@ static int find_uint_len(UIntType value, unsigned base)
 
 static void print_uint_generic(FormatCtx& ctx, const FormatSpec& format_spec, UIntType value, bool is_negative)
 {
+	// octal zero has no prefix: 0, not 00
+	if (format_spec.flags.octothorp && (format_spec.format == 'o') && (value == 0))
+	{
+		FormatSpec spec = format_spec;
+		spec.flags.octothorp = false;
+		print_uint_generic(ctx, spec, value, is_negative);
+		return;
+	}
+
 	unsigned base =
 		(format_spec.format == 'b') ? 2 :
 		(format_spec.format == 'd') ? 10 :
@@ -453,7 +253,7 @@ static void print_uint_generic(FormatCtx& ctx, const FormatSpec& format_spec, UI
 	unsigned char len = find_uint_len(value, base);
 	if (format_spec.flags.octothorp)
 	{
-		if ((format_spec.format == 'x') || (format_spec.format == 'b'))
+		if ((format_spec.format == 'x') || (format_spec.format == 'p') || (format_spec.format == 'b'))
 			len += 2;
 		else if (format_spec.format == 'o')
 			len++;
@@ -561,7 +361,7 @@ static void gather_data_to_print_float(FloatType value, int precision, bool uppe
 		return;
 	}
 
-	result.is_negative = value < (FloatType)0.0f;
+	result.is_negative = signbit(value); // -0.0 is printed with sign
 	if (result.is_negative)
 		value = -value;
 
@@ -633,8 +433,130 @@ static void printf_float_number(const PrintFloatData data, DstData &dst, int pre
 	}
 }
 
+/* Fast path: value is scaled by power of ten once and rounded to integer,
+   digits are made by integer division. Result is correctly rounded (ties
+   to even) against exact value of argument. Values too large to be scaled
+   exactly, nan and inf are printed by code above */
+
+#if defined (MICRO_FORMAT_DOUBLE)
+constexpr int MaxFastFloatPrecision = 15;
+constexpr FloatType MaxFastScaledFloat = 4503599627370496.0; // 2^52: fraction of scaled value is exact
+constexpr FloatType FloatSplitter = 134217729.0; // 2^27 + 1
+#else
+constexpr int MaxFastFloatPrecision = 9;
+constexpr FloatType MaxFastScaledFloat = 8388608.0f; // 2^23
+constexpr FloatType FloatSplitter = 4097.0f; // 2^12 + 1
+#endif
+
+static const FloatType float_pow10[MaxFastFloatPrecision + 1] = {
+	1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f,
+#if defined (MICRO_FORMAT_DOUBLE)
+	1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+#endif
+};
+
+struct FloatDigits
+{
+	char buffer[24];
+	const char* text; // integral and decimal digits without point
+	int len;
+	int integral_len;
+	bool is_negative;
+};
+
+// rounding error of product a*b (Dekker's algorithm)
+static FloatType get_product_error(FloatType a, FloatType b, FloatType product)
+{
+	auto split = [](FloatType value, FloatType &hi, FloatType &lo)
+	{
+		FloatType t = FloatSplitter * value;
+		hi = t - (t - value);
+		lo = value - hi;
+	};
+
+	FloatType a_hi = 0, a_lo = 0, b_hi = 0, b_lo = 0;
+	split(a, a_hi, a_lo);
+	split(b, b_hi, b_lo);
+	return ((a_hi * b_hi - product) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+}
+
+static char* put_uint64_digits(char* end, uint64_t value, int min_digits)
+{
+	// 64-bit division only while value doesn't fit into 32 bits
+	while (value > UINT32_MAX)
+	{
+		uint64_t div = value / 10;
+		*--end = '0' + (char)(value - div * 10);
+		value = div;
+		min_digits--;
+	}
+
+	uint32_t value32 = (uint32_t)value;
+	do
+	{
+		*--end = '0' + (char)(value32 % 10);
+		value32 /= 10;
+		min_digits--;
+	}
+	while (value32 || (min_digits > 0));
+
+	return end;
+}
+
+static bool get_float_digits(FloatType value, int precision, FloatDigits &result)
+{
+	if ((precision < 0) || (precision > MaxFastFloatPrecision)) return false;
+
+	result.is_negative = signbit(value); // -0.0 is printed with sign
+	if (result.is_negative) value = -value;
+
+	const FloatType scale = float_pow10[precision];
+	const FloatType scaled = value * scale;
+	if (!(scaled < MaxFastScaledFloat)) return false; // nan and inf too
+
+	uint64_t int_value = (uint64_t)scaled;
+	const FloatType frac = scaled - (FloatType)int_value;
+	const FloatType half = (FloatType)0.5f;
+
+	// if fraction is exactly 0.5 rounding error of scaling decides
+	bool round_up = frac > half;
+	if (frac == half)
+	{
+		FloatType error = get_product_error(value, scale, scaled);
+		round_up = (error > 0) || ((error == 0) && (int_value & 1));
+	}
+	if (round_up) int_value++;
+
+	char* end = result.buffer + sizeof(result.buffer);
+	result.text = put_uint64_digits(end, int_value, precision + 1);
+	result.len = end - result.text;
+	result.integral_len = result.len - precision;
+
+	return true;
+}
+
+static void print_float_digits(DstData &dst, const FloatDigits &digits, int precision)
+{
+	print_text(dst, digits.text, digits.integral_len);
+	if (precision == 0) return;
+	put_char(dst, '.');
+	print_text(dst, digits.text + digits.integral_len, precision);
+}
+
 static void print_float(FormatCtx& ctx, const FormatSpec& format_spec, FloatType value)
 {
+	FloatDigits digits;
+	if (get_float_digits(value, format_spec.precision, digits))
+	{
+		int len = digits.len + (format_spec.precision ? 1 : 0);
+		if (digits.is_negative || (format_spec.sign == '+') || (format_spec.sign == ' ')) len++;
+
+		print_sign_and_leading_spaces(ctx, format_spec, digits.is_negative, len, false);
+		print_float_digits(ctx.dst, digits, format_spec.precision);
+		print_trailing_spaces(ctx, format_spec, len);
+		return;
+	}
+
 	PrintFloatData data{};
 
 	gather_data_to_print_float(value, format_spec.precision, format_spec.flags.upper_case, data);
@@ -666,7 +588,7 @@ static void print_float(FormatCtx& ctx, const FormatSpec& format_spec, FloatType
 
 	// print sign, leading spaces or zeros
 
-	print_sign_and_leading_spaces(ctx, format_spec, data.is_negative, len, true);
+	print_sign_and_leading_spaces(ctx, format_spec, data.is_negative, len, false);
 
 	// integral and decimal parts
 
@@ -760,39 +682,83 @@ void format_impl(FormatCtx& ctx, const char* format_str)
 
 	for (;;)
 	{
-		char chr = *format_str++;
-		if (chr == 0) break;
+		// text before next specifier is printed by one call
+		const char* text = format_str;
+		while (*format_str && (*format_str != '{')) format_str++;
+		put_text(ctx.dst, text, format_str - text);
 
-		if (chr == '{')
+		if (*format_str++ == 0) break;
+
+		if (*format_str != '{')
 		{
-			if (*format_str != '{')
-			{
-				FormatSpec spec {};
+			FormatSpec spec {};
 
-				format_str = get_format_specifier(format_str, spec, index);
+			format_str = get_format_specifier(format_str, spec, index);
 
-				bool ok = spec.flags.parsed_ok && check_format_specifier(ctx, spec);
+			bool ok =
+				spec.flags.parsed_ok &&
+				(spec.index < ctx.args_count) &&
+				check_format_specifier(ctx.args[spec.index].type, spec);
 
-				if (ok)
-				{
-					correct_format_specifier(ctx, spec);
-					print_by_argument_type(ctx, spec);
-					index++;
-				}
-				else
-					print_error(ctx);
-			}
-			else
+			if (ok)
 			{
-				put_char(ctx.dst, '{');
-				format_str++;
+				correct_format_specifier(ctx.args[spec.index].type, spec);
+				print_by_argument_type(ctx, spec);
+				index++;
 			}
+			else
+				print_error(ctx);
 		}
 		else
-			put_char(ctx.dst, chr);
+		{
+			put_char(ctx.dst, '{');
+			format_str++;
+		}
 	}
 }
 
+void print_text(DstData& dst, const char* text, size_t len)
+{
+	put_text(dst, text, len);
+}
+
+void print_char_arg(FormatCtx& ctx, const FormatSpec& format_spec, char value)
+{
+	print_char(ctx, format_spec, value);
+}
+
+void print_int_arg(FormatCtx& ctx, const FormatSpec& format_spec, IntType value)
+{
+	print_int(ctx, format_spec, value);
+}
+
+void print_uint_arg(FormatCtx& ctx, const FormatSpec& format_spec, UIntType value)
+{
+	print_uint(ctx, format_spec, value);
+}
+
+void print_bool_arg(FormatCtx& ctx, const FormatSpec& format_spec, bool value)
+{
+	print_bool(ctx, format_spec, value);
+}
+
+void print_string_arg(FormatCtx& ctx, const FormatSpec& format_spec, const char* value)
+{
+	print_string(ctx, format_spec, value);
+}
+
+void print_pointer_arg(FormatCtx& ctx, const FormatSpec& format_spec, const void* value)
+{
+	print_pointer(ctx, format_spec, value);
+}
+
+#if defined (MICRO_FORMAT_FLOAT) || defined (MICRO_FORMAT_DOUBLE)
+void print_float_arg(FormatCtx& ctx, const FormatSpec& format_spec, FloatType value)
+{
+	print_float(ctx, format_spec, value);
+}
+#endif
+
 bool format_buf_callback(void* data, char character)
 {
 	auto* sdata = (FormatBufData*)data;
@@ -804,68 +770,89 @@ bool format_buf_callback(void* data, char character)
 	return true;
 }
 
+size_t format_buf_text_callback(void* data, const char* text, size_t len)
+{
+	auto* sdata = (FormatBufData*)data;
+	if (len > sdata->buffer_size) len = sdata->buffer_size;
+
+	for (size_t i = 0; i < len; i++)
+		*sdata->buffer++ = *text++;
+	sdata->buffer_size -= len;
+
+	return len;
+}
+
 bool utf8_char_callback(void* data, char chr)
 {
 	Utf8Receiver* r = (Utf8Receiver*)data;
 
 	bool ok = true;
 
-	if (r->count == 0)
+	if (r->count != 0)
 	{
-		if ((chr & 0b10000000) == 0)
+		if ((chr & 0b11000000) == 0b10000000)
 		{
-			ok = r->cb(r->cb_data, chr);
-			r->chars_printed++;
-		}
+			r->character <<= 6;
+			r->character |= (chr & 0b00111111);
 
-		else if ((chr & 0b11100000) == 0b11000000)
-		{
-			r->character = chr & 0b00011111;
-			r->count = 1;
-		}
+			r->count--;
 
-		else if ((chr & 0b11110000) == 0b11100000)
-		{
-			r->character = chr & 0b00001111;
-			r->count = 2;
-		}
+			if (r->count == 0)
+			{
+				ok = r->cb(r->cb_data, r->character);
+				r->chars_printed++;
+			}
 
-		else if ((chr & 0b11111000) == 0b11110000)
-		{
-			r->character = chr & 0b00000111;
-			r->count = 3;
+			return ok;
 		}
 
-		else
-		{
-			ok = r->cb(r->cb_data, r->wrong_char);
-			r->chars_printed++;
-		}
+		// sequence is broken. Character which broke it is decoded from start
+		ok = r->cb(r->cb_data, r->wrong_char);
+		r->count = 0;
+		r->chars_printed++;
 	}
-	else
+
+	if ((chr & 0b10000000) == 0)
 	{
-		if ((chr & 0b11000000) != 0b10000000)
-		{
-			ok = r->cb(r->cb_data, r->wrong_char);
-			r->count = 0;
-			r->chars_printed++;
-		}
+		ok = r->cb(r->cb_data, chr) && ok;
+		r->chars_printed++;
+	}
 
-		r->character <<= 6;
-		r->character |= (chr & 0b00111111);
+	else if ((chr & 0b11100000) == 0b11000000)
+	{
+		r->character = chr & 0b00011111;
+		r->count = 1;
+	}
+
+	else if ((chr & 0b11110000) == 0b11100000)
+	{
+		r->character = chr & 0b00001111;
+		r->count = 2;
+	}
 
-		r->count--;
+	else if ((chr & 0b11111000) == 0b11110000)
+	{
+		r->character = chr & 0b00000111;
+		r->count = 3;
+	}
 
-		if (r->count == 0)
-		{
-			ok = r->cb(r->cb_data, r->character);
-			r->chars_printed++;
-		}
+	else
+	{
+		ok = r->cb(r->cb_data, r->wrong_char) && ok;
+		r->chars_printed++;
 	}
 
 	return ok;
 }
 
+size_t utf8_text_callback(void* data, const char* text, size_t len)
+{
+	size_t result = 0;
+	while (len--)
+		if (utf8_char_callback(data, *text++)) result++;
+	return result;
+}
+
 } // namespace impl
 
 static size_t format_uint_impl(FormatCallback callback, void* data, unsigned value, unsigned base)
@@ -943,6 +930,15 @@ size_t format_bin(char* buffer, size_t buffer_size, unsigned value)
 size_t format_float(FormatCallback callback, void* cb_data, impl::FloatType value, int precision)
 {
 	impl::DstData dst{ callback, cb_data, 0 };
+
+	impl::FloatDigits digits;
+	if (impl::get_float_digits(value, precision, digits))
+	{
+		if (digits.is_negative) put_char(dst, '-');
+		impl::print_float_digits(dst, digits, precision);
+		return dst.chars_printed;
+	}
+
 	impl::PrintFloatData data{};
 
 	impl::gather_data_to_print_float(value, precision, false, data);
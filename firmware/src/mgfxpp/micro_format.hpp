@@ -37,6 +37,10 @@ using WideChar = uint32_t;
 using FormatCallback = bool (*)(void* data, char character);
 using FormatWideCallback = bool (*)(void* data, WideChar character);
 
+// Receives contiguous runs of text (literal parts, whole numbers) instead
+// of single characters. Returns number of characters accepted
+using FormatTextCallback = size_t (*)(void* data, const char* text, size_t len);
+
 namespace impl {
 
 #if defined (MICRO_FORMAT_DOUBLE)
@@ -100,9 +104,10 @@ struct FormatArg
 
 struct DstData
 {
-	const FormatCallback callback;
-	void* const          data;
-	size_t               chars_printed;
+	const FormatCallback     callback;
+	void* const              data;
+	size_t                   chars_printed;
+	const FormatTextCallback text_callback = nullptr; // used instead of callback if set
 };
 
 struct FormatCtx
@@ -114,6 +119,271 @@ struct FormatCtx
 
 void format_impl(FormatCtx& ctx, const char* format_str);
 
+#if defined (MICRO_FORMAT_INT64)
+	using UIntType = unsigned long long;
+	using IntType = long long;
+#else
+	using UIntType = unsigned long;
+	using IntType = long;
+#endif
+
+/* Format specifier parsing. Functions are constexpr to be used both by
+   runtime format_impl() and by compile-time front end (MF_FMT) */
+
+struct FormatSpecFlags
+{
+	uint8_t octothorp : 1;
+	uint8_t upper_case : 1;
+	uint8_t zero : 1;
+	uint8_t parsed_ok : 1;
+};
+
+struct FormatSpec
+{
+	int width = -1;
+	int precision = -1;
+	int length = -1;
+	int index = -1;
+	FormatSpecFlags flags{};
+	char align = 0; // '<', '^', '>'
+	char sign = 0;  // '+', '-', ' '
+	char format = 0;
+};
+
+constexpr bool is_integer_arg_type(FormatArgType arg_type)
+{
+	return
+		(arg_type == FormatArgType::Short) ||
+		(arg_type == FormatArgType::UShort) ||
+		(arg_type == FormatArgType::Int) ||
+		(arg_type == FormatArgType::UInt) ||
+		(arg_type == FormatArgType::Long) ||
+		(arg_type == FormatArgType::ULong);
+}
+
+constexpr bool is_float_arg_type(FormatArgType arg_type)
+{
+	return
+		(arg_type == FormatArgType::Float) ||
+		(arg_type == FormatArgType::Double);
+}
+
+constexpr bool is_char_arg_type(FormatArgType arg_type)
+{
+	return
+		(arg_type == FormatArgType::Char);
+}
+
+constexpr bool is_bool_arg_type(FormatArgType arg_type)
+{
+	return
+		(arg_type == FormatArgType::Bool);
+}
+
+constexpr bool is_str_arg_type(FormatArgType arg_type)
+{
+	return
+		(arg_type == FormatArgType::CharPtr);
+}
+
+constexpr const char* get_format_specifier(const char* format_str, FormatSpec& format_spec, int index)
+{
+	enum class State : uint8_t
+	{
+		Undef,
+		IndexSpecified,
+		PtPassed,
+		PrecSpecified,
+		FormatSpecified,
+		Finished
+	};
+
+	State state = State::Undef;
+
+	const char* orig_format_str = format_str;
+
+	int* int_value = &format_spec.index;
+
+	for (;;)
+	{
+		unsigned char chr = (unsigned char)*format_str++;
+
+		if ((chr >= '0') && (chr <= '9'))
+		{
+			if ((state >= State::IndexSpecified) &&
+				(state < State::PtPassed) &&
+				(chr == '0') &&
+				(*int_value == -1))
+			{
+				format_spec.flags.zero = true;
+				continue;
+			}
+			else if (int_value)
+			{
+				if (*int_value == -1) *int_value = 0;
+				*int_value *= 10;
+				*int_value += chr - '0';
+				continue;
+			}
+			else
+				return orig_format_str;
+		}
+		else if (int_value && (*int_value != -1))
+			int_value = nullptr;
+
+		switch (chr)
+		{
+		case ':':
+			if (state == State::Undef)
+			{
+				int_value = &format_spec.width;
+				state = State::IndexSpecified;
+			}
+			else
+				return orig_format_str;
+			break;
+
+		case '.':
+			if ((state >= State::IndexSpecified) && (state < State::PtPassed))
+			{
+				int_value = &format_spec.precision;
+				state = State::PtPassed;
+			}
+			else
+				return orig_format_str;
+			break;
+
+		case '<': case '>': case '^':
+			if (format_spec.align == 0)
+				format_spec.align = chr;
+			else
+				return orig_format_str;
+			break;
+
+		case '+': case '-': case ' ':
+			if (format_spec.sign == 0)
+				format_spec.sign = chr;
+			else
+				return orig_format_str;
+			break;
+
+		case '#':
+			format_spec.flags.octothorp = true;
+			break;
+
+		case 'B': case 'b': case 'd':
+		case 'o': case 'x': case 'X':
+		case 'c': case 'f': case 'F':
+		case 's':
+			if (format_spec.format == 0)
+				format_spec.format = chr;
+			else
+				return orig_format_str;
+			state = State::FormatSpecified;
+			break;
+
+		case '}':
+			state = State::Finished;
+			break;
+
+		default:
+			return orig_format_str;
+		}
+
+		if (state == State::Finished) break;
+	}
+
+	auto user_format = format_spec.format;
+	switch (format_spec.format)
+	{
+	case 'F': format_spec.format = 'f'; break;
+	case 'X': format_spec.format = 'x'; break;
+	case 'B': format_spec.format = 'b'; break;
+	}
+	format_spec.flags.upper_case = (user_format != format_spec.format);
+
+	format_spec.flags.parsed_ok = true;
+
+	if (format_spec.index == -1)
+		format_spec.index = index;
+
+	return format_str;
+}
+
+constexpr bool check_format_specifier(FormatArgType type, const FormatSpec& format_spec)
+{
+	auto f = format_spec.format;
+
+	if (is_float_arg_type(type) && (f != 'f') && (f != 0))
+		return false;
+
+	bool is_integer_presentation =
+		(f == 'b') || (f == 'd') || (f == 'o') || (f == 'x');
+
+	if ((is_integer_arg_type(type) || is_char_arg_type(type)) &&
+	    !is_integer_presentation && (f != 'c') && (f != 0))
+		return false;
+
+	if (is_bool_arg_type(type) && !is_integer_presentation && (f != 's') && (f != 0))
+		return false;
+
+	if (is_str_arg_type(type) && (f != 's') && (f != 0))
+		return false;
+
+	return true;
+}
+
+constexpr void correct_format_specifier(FormatArgType arg_type, FormatSpec& format_spec)
+{
+	if (format_spec.align == 0)
+	{
+		auto f = format_spec.format;
+		bool is_integer_presentation = (f == 'b') || (f == 'd') || (f == 'o') || (f == 'x');
+
+		// chars and bools printed as numbers are aligned as numbers
+		if (is_integer_arg_type(arg_type) || is_float_arg_type(arg_type) || is_integer_presentation)
+			format_spec.align = '>';
+		else
+			format_spec.align = '<';
+	}
+
+	switch (arg_type)
+	{
+	case FormatArgType::Pointer:
+		if (format_spec.format == 0)
+		{
+			format_spec.format = 'p';
+			format_spec.flags.zero = true;
+			format_spec.flags.octothorp = true;
+
+			if (format_spec.width == -1)
+				format_spec.width = 2 * sizeof(void*) + (format_spec.flags.octothorp ? 2 : 0);
+		}
+		break;
+
+	case FormatArgType::Float:
+	case FormatArgType::Double:
+		if (format_spec.precision == -1)
+			format_spec.precision = 6;
+		break;
+
+	default:
+		break;
+	}
+}
+
+// Printing of one argument by already checked and corrected format specifier
+void print_text(DstData& dst, const char* text, size_t len);
+void print_char_arg(FormatCtx& ctx, const FormatSpec& format_spec, char value);
+void print_int_arg(FormatCtx& ctx, const FormatSpec& format_spec, IntType value);
+void print_uint_arg(FormatCtx& ctx, const FormatSpec& format_spec, UIntType value);
+void print_bool_arg(FormatCtx& ctx, const FormatSpec& format_spec, bool value);
+void print_string_arg(FormatCtx& ctx, const FormatSpec& format_spec, const char* value);
+void print_pointer_arg(FormatCtx& ctx, const FormatSpec& format_spec, const void* value);
+#if defined (MICRO_FORMAT_FLOAT) || defined (MICRO_FORMAT_DOUBLE)
+void print_float_arg(FormatCtx& ctx, const FormatSpec& format_spec, FloatType value);
+#endif
+
 // callback data for printing into string buffer
 struct FormatBufData
 {
@@ -122,6 +392,7 @@ struct FormatBufData
 };
 
 bool format_buf_callback(void* data, char character);
+size_t format_buf_text_callback(void* data, const char* text, size_t len);
 
 template <typename PrintFun>
 size_t format_buf_impl(char* buffer, size_t buffer_size, const PrintFun &print_fun)
@@ -145,6 +416,7 @@ struct Utf8Receiver
 };
 
 bool utf8_char_callback(void* data, char chr);
+size_t utf8_text_callback(void* data, const char* text, size_t len);
 
 } // namespace impl
 
@@ -162,6 +434,17 @@ size_t format(FormatCallback callback, void* data, const char* format_str, const
 	return ctx.dst.chars_printed;
 }
 
+// Print values formating by {} syntax calling callback for each run of text
+template <typename ... Args>
+size_t format(FormatTextCallback callback, void* data, const char* format_str, const Args& ... args)
+{
+	constexpr unsigned arr_size = (sizeof ... (args)) ? (sizeof ... (args)) : 1;
+	const impl::FormatArg args_arr[arr_size] = { args ... };
+	impl::FormatCtx ctx{ { nullptr, data, 0, callback }, args_arr, sizeof ... (args) };
+	impl::format_impl(ctx, format_str);
+	return ctx.dst.chars_printed;
+}
+
 // Print values formating by {} syntax calling callback for each wide character
 // format_str and string arguments must be in utf8 enconding
 // Return value is number of wide chars printed in function
@@ -169,7 +452,7 @@ template <typename ... Args>
 size_t format_u8(FormatWideCallback callback, void* data, const char* format_str_utf8, const Args& ... args)
 {
 	impl::Utf8Receiver utf8 = { callback, data, 0, 0, '?', 0 };
-	format(impl::utf8_char_callback, &utf8, format_str_utf8, args...);
+	format(impl::utf8_text_callback, &utf8, format_str_utf8, args...);
 	return utf8.chars_printed;
 }
 
@@ -180,7 +463,7 @@ size_t format(char* buffer, size_t buffer_size, const char* format_str, const Ar
 	return impl::format_buf_impl(
 		buffer,
 		buffer_size,
-		[&](auto& data) { return format(impl::format_buf_callback, &data, format_str, args...); }
+		[&](auto& data) { return format(impl::format_buf_text_callback, &data, format_str, args...); }
 	);
 }
 
@@ -191,6 +474,224 @@ size_t format(char (&buffer)[BufSize], const char* format_str, const Args& ... a
 	return format(buffer, BufSize, format_str, args...);
 }
 
+/* Compile-time front end. Format string wrapped by MF_FMT is parsed while
+   compiling: wrong specifiers and argument types are reported by static_assert
+   and formatting is made by sequence of direct calls of printers for
+   text parts and arguments without parsing and type dispatching:
+
+   mf::format(callback, data, MF_FMT("value = {:.2}"), value); */
+
+template <typename Str>
+struct FormatString
+{
+	static constexpr const char* get() { return Str::get(); }
+};
+
+#define MF_FMT(str)                                                  \
+	([] {                                                            \
+		struct Str { static constexpr const char* get() { return str; } }; \
+		return mf::FormatString<Str>{};                              \
+	}())
+
+namespace impl {
+
+template <typename T>
+constexpr FormatArgType get_arg_type()
+{
+	using V = std::remove_cv_t<std::remove_reference_t<T>>;
+
+	if constexpr (std::is_same_v<V, char>)                    return FormatArgType::Char;
+	else if constexpr (std::is_same_v<V, unsigned char>)      return FormatArgType::UChar;
+	else if constexpr (std::is_same_v<V, short>)              return FormatArgType::Short;
+	else if constexpr (std::is_same_v<V, unsigned short>)     return FormatArgType::UShort;
+	else if constexpr (std::is_same_v<V, int>)                return FormatArgType::Int;
+	else if constexpr (std::is_same_v<V, unsigned int>)       return FormatArgType::UInt;
+	else if constexpr (std::is_same_v<V, long>)               return FormatArgType::Long;
+	else if constexpr (std::is_same_v<V, unsigned long>)      return FormatArgType::ULong;
+	else if constexpr (std::is_same_v<V, bool>)               return FormatArgType::Bool;
+	else if constexpr (std::is_same_v<std::decay_t<V>, const char*> || std::is_same_v<std::decay_t<V>, char*>)
+		return FormatArgType::CharPtr;
+	else if constexpr (std::is_pointer_v<std::decay_t<V>>)    return FormatArgType::Pointer;
+#if defined (MICRO_FORMAT_FLOAT) || defined (MICRO_FORMAT_DOUBLE)
+	else if constexpr (std::is_same_v<V, float>)              return FormatArgType::Float;
+#endif
+#if defined (MICRO_FORMAT_DOUBLE)
+	else if constexpr (std::is_same_v<V, double>)             return FormatArgType::Double;
+#endif
+#if defined(MICRO_FORMAT_INT64)
+	else if constexpr (std::is_same_v<V, long long>)          return FormatArgType::LLong;
+	else if constexpr (std::is_same_v<V, unsigned long long>) return FormatArgType::ULLong;
+#endif
+	else return FormatArgType::Undef;
+}
+
+template <unsigned Index, typename T, typename ... Rest>
+struct NthArg
+{
+	using Type = typename NthArg<Index - 1, Rest...>::Type;
+};
+
+template <typename T, typename ... Rest>
+struct NthArg<0, T, Rest...>
+{
+	using Type = T;
+};
+
+enum class FormatTokenType : uint8_t
+{
+	End,
+	Text,
+	Brace,
+	Field,
+	Error
+};
+
+// Part of format string starting at pos: text up to next brace, escaped brace or field
+struct FormatToken
+{
+	FormatTokenType type = FormatTokenType::End;
+	unsigned len = 0; // length of text
+	unsigned next_pos = 0;
+	int next_index = 0;
+	FormatSpec spec {};
+};
+
+constexpr FormatToken get_format_token(const char* format_str, unsigned pos, int index)
+{
+	FormatToken result {};
+	result.next_index = index;
+
+	const char* str = format_str + pos;
+
+	if (*str == 0)
+		return result;
+
+	if (*str != '{')
+	{
+		while (str[result.len] && (str[result.len] != '{')) result.len++;
+		result.type = FormatTokenType::Text;
+		result.next_pos = pos + result.len;
+		return result;
+	}
+
+	if (str[1] == '{')
+	{
+		result.type = FormatTokenType::Brace;
+		result.next_pos = pos + 2;
+		return result;
+	}
+
+	const char* end = get_format_specifier(str + 1, result.spec, index);
+	result.type = result.spec.flags.parsed_ok ? FormatTokenType::Field : FormatTokenType::Error;
+	result.next_pos = end - format_str;
+	result.next_index = index + 1;
+	return result;
+}
+
+constexpr FormatSpec get_corrected_format_specifier(FormatArgType type, FormatSpec spec)
+{
+	correct_format_specifier(type, spec);
+	return spec;
+}
+
+template <typename T>
+void print_arg(FormatCtx& ctx, const FormatSpec& spec, const T& value)
+{
+	constexpr FormatArgType type = get_arg_type<T>();
+
+	if constexpr ((type == FormatArgType::Char) || (type == FormatArgType::UChar))
+		print_char_arg(ctx, spec, (char)value);
+	else if constexpr (type == FormatArgType::Bool)
+		print_bool_arg(ctx, spec, value);
+	else if constexpr (type == FormatArgType::CharPtr)
+		print_string_arg(ctx, spec, value);
+	else if constexpr (type == FormatArgType::Pointer)
+		print_pointer_arg(ctx, spec, value);
+#if defined (MICRO_FORMAT_FLOAT) || defined (MICRO_FORMAT_DOUBLE)
+	else if constexpr (is_float_arg_type(type))
+		print_float_arg(ctx, spec, value);
+#endif
+	else if constexpr (std::is_signed_v<T>)
+		print_int_arg(ctx, spec, value);
+	else
+		print_uint_arg(ctx, spec, value);
+}
+
+template <typename Str, unsigned Pos, int Index, typename ... Args>
+void format_ct(FormatCtx& ctx, const void* const* args)
+{
+	constexpr FormatToken token = get_format_token(Str::get(), Pos, Index);
+
+	static_assert(token.type != FormatTokenType::Error, "Wrong format specifier");
+
+	if constexpr (token.type == FormatTokenType::End)
+		return;
+	else
+	{
+		if constexpr (token.type == FormatTokenType::Text)
+			print_text(ctx.dst, Str::get() + Pos, token.len);
+
+		else if constexpr (token.type == FormatTokenType::Brace)
+			print_text(ctx.dst, "{", 1);
+
+		else if constexpr (token.type == FormatTokenType::Field)
+		{
+			static_assert(token.spec.index < (int)sizeof ... (Args), "Not enough arguments for format string");
+
+			using Arg = typename NthArg<token.spec.index, Args...>::Type;
+			constexpr FormatArgType type = get_arg_type<Arg>();
+			static_assert(type != FormatArgType::Undef, "Type of argument is not supported");
+			static_assert(check_format_specifier(type, token.spec), "Format specifier doesn't match argument type");
+
+			constexpr FormatSpec spec = get_corrected_format_specifier(type, token.spec);
+
+			print_arg(ctx, spec, *(const Arg*)args[token.spec.index]);
+		}
+
+		format_ct<Str, token.next_pos, token.next_index, Args...>(ctx, args);
+	}
+}
+
+} // namespace impl
+
+// Print values formating by {} syntax parsed at compile time calling callback for each character
+template <typename Str, typename ... Args>
+size_t format(FormatCallback callback, void* data, FormatString<Str>, const Args& ... args)
+{
+	const void* args_arr[sizeof ... (args) + 1] = { &args ... };
+	impl::FormatCtx ctx{ { callback, data, 0 }, nullptr, 0 };
+	impl::format_ct<Str, 0, 0, Args...>(ctx, args_arr);
+	return ctx.dst.chars_printed;
+}
+
+// Print values formating by {} syntax parsed at compile time calling callback for each run of text
+template <typename Str, typename ... Args>
+size_t format(FormatTextCallback callback, void* data, FormatString<Str>, const Args& ... args)
+{
+	const void* args_arr[sizeof ... (args) + 1] = { &args ... };
+	impl::FormatCtx ctx{ { nullptr, data, 0, callback }, nullptr, 0 };
+	impl::format_ct<Str, 0, 0, Args...>(ctx, args_arr);
+	return ctx.dst.chars_printed;
+}
+
+// Print values formating by {} syntax parsed at compile time into buffer
+template <typename Str, typename ... Args>
+size_t format(char* buffer, size_t buffer_size, FormatString<Str> format_str, const Args& ... args)
+{
+	return impl::format_buf_impl(
+		buffer,
+		buffer_size,
+		[&](auto& data) { return format(impl::format_buf_text_callback, &data, format_str, args...); }
+	);
+}
+
+// Print values formating by {} syntax parsed at compile time into constant-sized buffer
+template <typename Str, typename ... Args, size_t BufSize>
+size_t format(char (&buffer)[BufSize], FormatString<Str> format_str, const Args& ... args)
+{
+	return format(buffer, BufSize, format_str, args...);
+}
+
 // Print integer as decimal value calling callback for each character
 size_t format_dec(FormatCallback callback, void* data, int value);
 
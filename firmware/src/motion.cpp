@@ -0,0 +1,285 @@
+#include <limits.h>
+
+#include "motion.hpp"
+#include "hardware.hpp"
+#include "tracking_math.hpp"
+
+constexpr TrackingFloat StepL = RodStep * TurnsOnStep; // rod length for one motor step
+
+// how far in time step schedule is filled ahead (in timer ticks)
+constexpr uint64_t ScheduleHorizon = TimerClock / 4;
+
+// position correction
+constexpr unsigned CorrectionPeriodMs = 100;
+constexpr TrackingFloat CorrectionKp = 0.5f;          // 1/s
+constexpr TrackingFloat CorrectionKi = 0.05f;         // 1/s^2
+constexpr TrackingFloat CorrectionDeadBand = 0.5f;    // steps
+constexpr TrackingFloat MaxCorrectionPart = 0.5f;     // of tracking speed
+constexpr TrackingFloat MaxCorrectionAccel = MaxStepMotorAccel / TurnsOnStep; // steps in sec^2
+
+constexpr TrackingFloat ArcsecInRad = 180.0 * 3600.0 / Pi;
+
+// dither move
+constexpr TrackingFloat MoveMaxSpeed = MoveSpeed / TurnsOnStep;        // steps in second
+constexpr TrackingFloat MoveAccel = MaxStepMotorAccel / TurnsOnStep;   // steps in sec^2
+constexpr TrackingFloat MoveMinL = StartL + 1.0;
+
+// reference for ideal angle
+static unsigned ref_time_counter = 0;
+static TrackingFloat ref_angle = 0;
+static TrackingFloat angle_offset = 0;
+
+// step schedule
+static unsigned sched_time_counter = 0; // time counter at start of schedule
+static uint64_t sched_ticks = 0;        // time of last scheduled step from start of schedule
+static int32_t next_step = 0;           // steps counter value after next scheduled step
+static TrackingFloat ticks_frac = 0;    // fractional part of timer ticks carried to next interval
+
+// position correction
+static unsigned prev_correction_time = 0;
+static TrackingFloat corr_speed = 0;    // steps in second
+static TrackingFloat err_integral = 0;  // steps * second
+
+// dither move
+static bool moving = false;
+static uint32_t move_steps = 0;         // steps in move
+static uint32_t move_next = 0;          // index of next scheduled step of move
+
+static TrackingErrorStat error_stat;
+
+static TrackingFloat calc_ideal_angle(unsigned time_counter)
+{
+	TrackingFloat time_in_sec = (TrackingFloat)(time_counter - ref_time_counter) / (TrackingFloat)TimeTimerFreq;
+	return ref_angle + time_in_sec * (TrackingFloat)RotSpeed;
+}
+
+// Interval to next step. Rod speed is taken in the middle of step,
+// fractional part of timer ticks is carried over to not accumulate error
+static uint16_t calc_next_interval()
+{
+	TrackingFloat l = steps_to_l<TrackingFloat>(next_step) + StepL / 2;
+	TrackingFloat steps_in_second = calc_l_speed(l) / StepL + corr_speed;
+	TrackingFloat ticks = (TrackingFloat)TimerClock / steps_in_second + ticks_frac;
+	uint32_t interval = (uint32_t)ticks;
+	ticks_frac = ticks - interval;
+	next_step++;
+
+	if (interval > USHRT_MAX) interval = USHRT_MAX;
+	if (interval < 2) interval = 2;
+
+	sched_ticks += interval;
+
+	return interval;
+}
+
+static void fill_step_schedule(unsigned time_counter)
+{
+	uint64_t ticks = (uint64_t)(time_counter - sched_time_counter) * (TimerClock / TimeTimerFreq);
+	while ((sched_ticks < ticks + ScheduleHorizon) && (get_step_schedule_free_space() != 0))
+		add_step_interval(calc_next_interval());
+}
+
+// Interval to next step of move. Speed in the middle of step is
+// limited by acceleration from start, by deceleration to stop at the
+// last step and by maximum move speed
+static uint16_t calc_move_interval()
+{
+	TrackingFloat from_start = move_next + (TrackingFloat)0.5f;
+	TrackingFloat to_end = move_steps - from_start;
+	TrackingFloat dist = (from_start < to_end) ? from_start : to_end;
+
+	TrackingFloat steps_in_second = sqrt(2 * MoveAccel * dist);
+	if (steps_in_second > MoveMaxSpeed) steps_in_second = MoveMaxSpeed;
+
+	TrackingFloat ticks = (TrackingFloat)TimerClock / steps_in_second + ticks_frac;
+	uint32_t interval = (uint32_t)ticks;
+	ticks_frac = ticks - interval;
+	move_next++;
+
+	if (interval > USHRT_MAX) interval = USHRT_MAX;
+	if (interval < 2) interval = 2;
+
+	sched_ticks += interval;
+
+	return interval;
+}
+
+static void fill_move_schedule(unsigned time_counter)
+{
+	uint64_t ticks = (uint64_t)(time_counter - sched_time_counter) * (TimerClock / TimeTimerFreq);
+	while ((move_next < move_steps) && (sched_ticks < ticks + ScheduleHorizon) && (get_step_schedule_free_space() != 0))
+		add_step_interval(calc_move_interval());
+}
+
+static void update_error_stat(TrackingFloat error)
+{
+	float value = (float)(error * ArcsecInRad);
+	if ((error_stat.count == 0) || (value < error_stat.min)) error_stat.min = value;
+	if ((error_stat.count == 0) || (value > error_stat.max)) error_stat.max = value;
+	error_stat.last = value;
+	error_stat.sum += value;
+	error_stat.sum_sq += value * value;
+	error_stat.count++;
+}
+
+// PI controller adds correction to speed of step schedule.
+// Correction is limited by part of tracking speed and by motor acceleration
+static void correct_position(unsigned time_counter, int32_t steps)
+{
+	const TrackingFloat dt = (TrackingFloat)(time_counter - prev_correction_time) / (TrackingFloat)TimeTimerFreq;
+
+	TrackingFloat target_angle = calc_ideal_angle(time_counter) + angle_offset;
+
+	// steps counter is behind continuous position by half of step in average
+	TrackingFloat l = steps_to_l<TrackingFloat>(steps) + StepL / 2;
+	update_error_stat(target_angle - calc_angle(l));
+
+	TrackingFloat error = (calc_l(target_angle) - l) / StepL; // in steps
+	if (fabs(error) < CorrectionDeadBand) error = 0;
+
+	err_integral += error * dt;
+
+	TrackingFloat speed = calc_l_speed(l) / StepL;
+	TrackingFloat max_corr = MaxCorrectionPart * speed;
+
+	if (CorrectionKi * err_integral > max_corr)
+		err_integral = max_corr / CorrectionKi;
+	else if (CorrectionKi * err_integral < -max_corr)
+		err_integral = -max_corr / CorrectionKi;
+
+	TrackingFloat new_corr = CorrectionKp * error + CorrectionKi * err_integral;
+
+	TrackingFloat max_corr_step = MaxCorrectionAccel * dt;
+	if (new_corr - corr_speed > max_corr_step)
+		new_corr = corr_speed + max_corr_step;
+	else if (new_corr - corr_speed < -max_corr_step)
+		new_corr = corr_speed - max_corr_step;
+
+	if (new_corr > max_corr)
+		new_corr = max_corr;
+	else if (new_corr < -max_corr)
+		new_corr = -max_corr;
+
+	corr_speed = new_corr;
+}
+
+void motion_start_tracking(bool new_reference)
+{
+	reset_step_schedule();
+	moving = false;
+
+	unsigned time_counter = get_time_counter();
+	next_step = get_steps_counter();
+
+	TrackingFloat angle = calc_angle(steps_to_l<TrackingFloat>(next_step));
+
+	if (new_reference)
+	{
+		ref_time_counter = time_counter;
+		ref_angle = angle;
+		error_stat = {};
+	}
+
+	angle_offset = angle - calc_ideal_angle(time_counter);
+
+	sched_time_counter = time_counter;
+	sched_ticks = 0;
+	ticks_frac = 0;
+
+	prev_correction_time = time_counter;
+	corr_speed = 0;
+	err_integral = 0;
+
+	if (steps_to_l<TrackingFloat>(next_step) >= (TrackingFloat)MaxL) return;
+
+	uint16_t first_interval = calc_next_interval();
+	fill_step_schedule(time_counter);
+	run_step_schedule(first_interval);
+}
+
+bool motion_start_move(TrackingFloat angle_diff)
+{
+	unsigned time_counter = get_time_counter();
+	int32_t steps = get_steps_counter();
+
+	// offset is taken from ideal angle, so offsets of moves don't add up
+	TrackingFloat target_l = calc_l(calc_ideal_angle(time_counter) + angle_diff);
+	if (target_l < (TrackingFloat)MoveMinL) target_l = MoveMinL;
+	if (target_l > (TrackingFloat)MaxL) target_l = MaxL;
+
+	int32_t diff = l_to_steps(target_l) - steps;
+	if (diff == 0) return false;
+
+	reset_step_schedule();
+
+	moving = true;
+	move_steps = (diff > 0) ? diff : -diff;
+	move_next = 0;
+
+	sched_time_counter = time_counter;
+	sched_ticks = 0;
+	ticks_frac = 0;
+
+	// schedule stops by itself at the last step
+	uint16_t first_interval = calc_move_interval();
+	fill_move_schedule(time_counter);
+	run_step_schedule(first_interval, diff > 0, move_steps);
+
+	return true;
+}
+
+void motion_update()
+{
+	if (!is_step_schedule_running()) return;
+
+	unsigned time_counter = get_time_counter();
+
+	if (moving)
+	{
+		fill_move_schedule(time_counter);
+		return;
+	}
+	int32_t steps = get_steps_counter();
+
+	if (steps_to_l<TrackingFloat>(steps) > (TrackingFloat)MaxL)
+	{
+		set_rotations_per_seconds(0);
+		return;
+	}
+
+	if ((time_counter - prev_correction_time) >= CorrectionPeriodMs * TimeTimerFreq / 1000)
+	{
+		correct_position(time_counter, steps);
+		prev_correction_time = time_counter;
+	}
+
+	fill_step_schedule(time_counter);
+}
+
+bool motion_is_tracking()
+{
+	return is_step_schedule_running() && !moving;
+}
+
+bool motion_is_moving()
+{
+	return is_step_schedule_running() && moving;
+}
+
+float motion_get_speed()
+{
+	if (!is_step_schedule_running()) return 0;
+	if (moving) return get_rotations_per_seconds();
+	TrackingFloat l = steps_to_l<TrackingFloat>(get_steps_counter()) + StepL / 2;
+	return (float)((calc_l_speed(l) / StepL + corr_speed) * TurnsOnStep);
+}
+
+TrackingFloat motion_get_ideal_angle()
+{
+	return calc_ideal_angle(get_time_counter());
+}
+
+const TrackingErrorStat& motion_get_error_stat()
+{
+	return error_stat;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+#include "config.hpp"
+
+/* Motion engine. Tracking is made by step schedule: time of each motor
+   step is calculated from tracker geometry, so step rate follows rod
+   speed exactly instead of being constant between speed updates.
+   Position error against ideal angle is corrected by PI controller
+   on top of the schedule. Dither moves are made by the same schedule
+   with trapezoidal speed profile to exact target step */
+
+// Tracking error statistics (in arc-seconds)
+struct TrackingErrorStat
+{
+	float last = 0;
+	float min = 0;
+	float max = 0;
+	float sum = 0;
+	float sum_sq = 0;
+	uint32_t count = 0;
+
+	float get_mean() const
+	{
+		return count ? sum / count : 0;
+	}
+
+	float get_rms() const
+	{
+		return count ? sqrtf(sum_sq / count) : 0;
+	}
+};
+
+// Starts tracking from current rod position. If new_reference is true
+// current angle becomes reference for ideal angle, otherwise tracking
+// keeps offset of current angle from ideal one (after dithering)
+void motion_start_tracking(bool new_reference);
+
+// Fills step schedule and corrects position. Must be called from main
+// loop often enough to not let step timer run out of intervals
+void motion_update();
+
+bool motion_is_tracking();
+
+// Starts move of rod to angle_diff (in radians) from ideal angle.
+// Tracking is stopped, motion_update() must be called while move is not
+// finished. Target is limited by rod length range. Returns false if
+// there is nothing to move
+bool motion_start_move(TrackingFloat angle_diff);
+
+bool motion_is_moving();
+
+// Rod rotations per second of step schedule at current position
+// (signed speed of move if moving)
+float motion_get_speed();
+
+// Ideal angle for current time
+TrackingFloat motion_get_ideal_angle();
+
+const TrackingErrorStat& motion_get_error_stat();
@@ -0,0 +1,68 @@
+#include "profiling.hpp"
+#include "debug_printf.hpp"
+
+static const char* const section_names[] = {
+	"time_timer_isr",
+	"step_counter_isr",
+	"calc_steps_period",
+	"motion_update",
+	"show_info_data",
+	"start_random_move",
+};
+
+static_assert(sizeof(section_names) / sizeof(section_names[0]) == (unsigned)ProfSection::Count);
+
+static uint64_t load_prev_time_us = 0;
+static uint64_t load_prev_busy_us = 0;
+
+static uint32_t ticks_to_us(uint32_t ticks)
+{
+	return (uint32_t)((uint64_t)ticks * 1'000'000 / ProfTicksFreq);
+}
+
+// CPU load and MCU current estimated by it since previous dump
+static void print_cpu_load()
+{
+	uint64_t time_us = (uint64_t)get_time_counter() * (1'000'000 / TimeTimerFreq);
+	uint64_t busy_us = get_cpu_busy_us();
+	if (time_us == load_prev_time_us) return;
+
+	float busy = (float)(busy_us - load_prev_busy_us) / (float)(time_us - load_prev_time_us);
+	float current = McuRunCurrentMa * busy + McuSleepCurrentMa * (1.0f - busy);
+
+	debug_printf(
+		"  cpu busy = {:.2} %, idle = {:.2} %, est. MCU current = {:.1} mA\n",
+		100.0f * busy,
+		100.0f * (1.0f - busy),
+		current
+	);
+
+	load_prev_time_us = time_us;
+	load_prev_busy_us = busy_us;
+}
+
+void prof_dump()
+{
+	if constexpr (ProfilingEnabled)
+	{
+		debug_printf("Profile ({}):\n", (ProfTicksFreq == SysClockFreq) ? "cycles" : "ns");
+
+		for (unsigned i = 0; i < (unsigned)ProfSection::Count; i++)
+		{
+			const ProfStat stat = prof_stats[i];
+			if (!stat.count) continue;
+
+			debug_printf(
+				MF_FMT("  {:<18} count = {:<8} min = {:<8} avg = {:<8} max = {:<8} ({} us)\n"),
+				section_names[i],
+				stat.count,
+				stat.min,
+				stat.get_avg(),
+				stat.max,
+				ticks_to_us(stat.max)
+			);
+		}
+
+		print_cpu_load();
+	}
+}
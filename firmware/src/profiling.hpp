@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "config.hpp"
+#include "hardware.hpp"
+
+#if defined(HOST_SIM)
+#include <chrono>
+#else
+#include <libopencm3/cm3/dwt.h>
+#endif
+
+/* Lightweight profiler. Keeps min/max/avg time of named code sections
+   measured by DWT cycle counter (std::chrono in host simulation):
+
+       {
+           ProfScope scope(ProfSection::MotionUpdate);
+           ...
+       }
+
+   Each section must be measured from one context only (one ISR or
+   main loop), so statistics are not protected from interrupts.
+   Nothing is compiled when ProfilingEnabled is false */
+
+enum class ProfSection : uint8_t
+{
+	TimeTimerIsr,
+	StepCounterIsr,
+	CalcStepsPeriod,
+	MotionUpdate,
+	ShowInfo,
+	RandomMove,
+	Count
+};
+
+#if defined(HOST_SIM)
+constexpr uint32_t ProfTicksFreq = 1'000'000'000; // nanoseconds
+#else
+constexpr uint32_t ProfTicksFreq = SysClockFreq; // CPU cycles
+#endif
+
+struct ProfStat
+{
+	uint32_t min = UINT32_MAX;
+	uint32_t max = 0;
+	uint32_t count = 0;
+	uint64_t sum = 0;
+
+	uint32_t get_avg() const
+	{
+		return count ? (uint32_t)(sum / count) : 0;
+	}
+};
+
+inline ProfStat prof_stats[(unsigned)ProfSection::Count] = {};
+
+inline uint32_t prof_get_ticks()
+{
+#if defined(HOST_SIM)
+	auto time = std::chrono::steady_clock::now().time_since_epoch();
+	return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+#else
+	return DWT_CYCCNT;
+#endif
+}
+
+inline void prof_add(ProfSection section, uint32_t ticks)
+{
+	auto &stat = prof_stats[(unsigned)section];
+	if (ticks < stat.min) stat.min = ticks;
+	if (ticks > stat.max) stat.max = ticks;
+	stat.sum += ticks;
+	stat.count++;
+}
+
+class ProfScope
+{
+public:
+	explicit ProfScope(ProfSection section)
+	{
+		if constexpr (ProfilingEnabled)
+		{
+			section_ = section;
+			start_ = prof_get_ticks();
+		}
+	}
+
+	~ProfScope()
+	{
+		if constexpr (ProfilingEnabled)
+			prof_add(section_, prof_get_ticks() - start_);
+	}
+
+	ProfScope(const ProfScope&) = delete;
+	ProfScope& operator = (const ProfScope&) = delete;
+
+private:
+	ProfSection section_ = {};
+	uint32_t start_ = 0;
+};
+
+// Prints statistics of all measured sections by debug_printf
+void prof_dump();
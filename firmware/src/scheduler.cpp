@@ -0,0 +1,84 @@
+#include "scheduler.hpp"
+
+static SchedJob* first_job = nullptr;
+
+static bool is_expired(unsigned deadline, unsigned time_counter)
+{
+	return (int32_t)(time_counter - deadline) >= 0;
+}
+
+// jobs with the same deadline are run in order they are inserted
+static void insert_job(SchedJob &job)
+{
+	SchedJob** link = &first_job;
+	while (*link && is_expired((*link)->deadline, job.deadline))
+		link = &(*link)->next;
+
+	job.next = *link;
+	*link = &job;
+	job.active = true;
+}
+
+static void remove_job(SchedJob &job)
+{
+	for (SchedJob** link = &first_job; *link; link = &(*link)->next)
+	{
+		if (*link != &job) continue;
+		*link = job.next;
+		break;
+	}
+
+	job.next = nullptr;
+	job.active = false;
+}
+
+// Job is rescheduled before callback is called, so callback can restart
+// or stop it. Periodical job late by more than period (after main loop
+// was blocked) is not run several times to catch up
+static void run_job(SchedJob &job, unsigned time_counter)
+{
+	remove_job(job);
+
+	if (job.period)
+	{
+		job.deadline += job.period;
+		if (is_expired(job.deadline, time_counter))
+			job.deadline = time_counter + job.period;
+		insert_job(job);
+	}
+
+	job.callback();
+}
+
+void sched_start(SchedJob &job, unsigned deadline, unsigned period)
+{
+	if (job.active) remove_job(job);
+
+	job.deadline = deadline;
+	job.period = period;
+	insert_job(job);
+}
+
+void sched_stop(SchedJob &job)
+{
+	if (job.active) remove_job(job);
+}
+
+unsigned sched_get_time_left(const SchedJob &job, unsigned time_counter)
+{
+	if (!job.active || is_expired(job.deadline, time_counter)) return 0;
+	return job.deadline - time_counter;
+}
+
+void sched_run(unsigned time_counter)
+{
+	while (first_job && is_expired(first_job->deadline, time_counter))
+		run_job(*first_job, time_counter);
+}
+
+bool sched_get_next_deadline(unsigned &deadline)
+{
+	if (!first_job) return false;
+	deadline = first_job->deadline;
+	return true;
+}
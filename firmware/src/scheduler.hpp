@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Deadline scheduler of main loop jobs. Active jobs are kept in list
+   sorted by deadline, so only the first job is checked when nothing is
+   expired, whatever number of jobs is registered. Job is rescheduled by
+   its period or stopped after it is run once if period is 0.
+
+   Times are time counter values (TimeTimerFreq ticks) compared by signed
+   difference, so time counter wraparound is handled. Deadline must not
+   be more than 2^31 ticks ahead. Jobs are used from main loop only:
+
+       static SchedJob job = { on_job_time };
+       sched_start(job, get_time_counter() + delay, period);
+       ...
+       sched_run(get_time_counter()); */
+
+using SchedCallback = void (*)();
+
+struct SchedJob
+{
+	SchedCallback callback = nullptr;
+	unsigned deadline = 0;
+	unsigned period = 0;      // 0 for one-shot job
+	bool active = false;
+	SchedJob* next = nullptr; // next job in list of active jobs
+};
+
+// (Re)starts job. It is run first time at deadline
+void sched_start(SchedJob &job, unsigned deadline, unsigned period = 0);
+
+void sched_stop(SchedJob &job);
+
+// Ticks before job is run. 0 if job is expired or stopped
+unsigned sched_get_time_left(const SchedJob &job, unsigned time_counter);
+
+// Runs all expired jobs in order of their deadlines
+void sched_run(unsigned time_counter);
+
+// Deadline of the first job. Returns false if there are no active jobs
+bool sched_get_next_deadline(unsigned &deadline);
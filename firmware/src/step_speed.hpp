@@ -0,0 +1,89 @@
+#pragma once
+
+#include <math.h>
+#include <limits.h>
+#include <stdint.h>
+
+#include "hardware.hpp"
+
+constexpr unsigned RecalcMotorSpeedFreq = 100; // Hz
+
+/* Speed mode of step motor without register access, shared by hardware
+   and simulated hardware. Speed (rotations per second, negative for
+   backward) is changed towards desired speed by MaxStepMotorAccel each
+   time update() is called (RecalcMotorSpeedFreq times in second), backend
+   loads step timer from get_reload_value() and direction of the speed.
+   Reload value is step timer period in TimerClock ticks */
+
+class StepSpeed
+{
+public:
+	static float calc_speed(uint32_t reload_value, bool forward)
+	{
+		float rotations_per_seconds = (float)TimerClock / reload_value * TurnsOnStep;
+		return forward ? rotations_per_seconds : -rotations_per_seconds;
+	}
+
+	void set_desired(float value)
+	{
+		desired_ = value;
+	}
+
+	float get_desired() const
+	{
+		return desired_;
+	}
+
+	float get() const
+	{
+		return current_;
+	}
+
+	// returns false if motor must be stopped
+	bool update()
+	{
+		constexpr float max_v_step = MaxStepMotorAccel / RecalcMotorSpeedFreq;
+
+		float cur_speed = current_;
+		float v_step = desired_ - cur_speed;
+		if (v_step > max_v_step)
+			v_step = max_v_step;
+		else if (v_step < -max_v_step)
+			v_step = -max_v_step;
+
+		cur_speed += v_step;
+		current_ = cur_speed;
+
+		return fabs(cur_speed) > 1e-5;
+	}
+
+	bool is_forward() const
+	{
+		return current_ > 0.0f;
+	}
+
+	uint32_t get_reload_value() const
+	{
+		float steps_in_second = fabs(current_) / TurnsOnStep;
+		uint32_t reload_value = (uint32_t)(TimerClock / steps_in_second + 0.5);
+		if (reload_value > USHRT_MAX) reload_value = USHRT_MAX;
+		return reload_value;
+	}
+
+	// step schedule is stopped, speed mode continues from its last step
+	// interval and direction
+	void continue_schedule(uint32_t reload_value, bool forward)
+	{
+		current_ = calc_speed(reload_value, forward);
+	}
+
+	void stop()
+	{
+		desired_ = 0;
+		current_ = 0;
+	}
+
+private:
+	volatile float desired_ = 0;
+	volatile float current_ = 0;
+};
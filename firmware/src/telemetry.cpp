@@ -0,0 +1,121 @@
+#include <string.h>
+
+#include "telemetry.hpp"
+
+// COBS encoded block is never longer than 254 bytes here
+static_assert(TelemetryPayloadSize + 2 < 254);
+
+// type, time, steps, 2 speeds and error, seconds to dither, state
+static_assert(1 + 8 + 4 + 3 * 4 + 2 + 1 == TelemetryPayloadSize);
+
+uint16_t telemetry_crc16(const uint8_t *data, unsigned size)
+{
+	uint16_t crc = 0xFFFF;
+	for (unsigned i = 0; i < size; i++)
+	{
+		crc ^= (uint16_t)data[i] << 8;
+		for (unsigned bit = 0; bit < 8; bit++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+	return crc;
+}
+
+template <typename T>
+static uint8_t* put_value(uint8_t *dst, T value)
+{
+	// MCU and host are both little-endian
+	memcpy(dst, &value, sizeof(value));
+	return dst + sizeof(value);
+}
+
+template <typename T>
+static const uint8_t* get_value(const uint8_t *src, T &value)
+{
+	memcpy(&value, src, sizeof(value));
+	return src + sizeof(value);
+}
+
+unsigned telemetry_encode(const TelemetryFrame &frame, uint8_t *buffer)
+{
+	uint8_t data[TelemetryPayloadSize + 2];
+
+	uint8_t *ptr = data;
+	ptr = put_value(ptr, TelemetryFrameType);
+	ptr = put_value(ptr, frame.time_ms);
+	ptr = put_value(ptr, frame.steps);
+	ptr = put_value(ptr, frame.commanded_rps);
+	ptr = put_value(ptr, frame.current_rps);
+	ptr = put_value(ptr, frame.angle_error);
+	ptr = put_value(ptr, frame.seconds_to_dither);
+	ptr = put_value(ptr, (uint8_t)frame.state);
+	ptr = put_value(ptr, telemetry_crc16(data, TelemetryPayloadSize));
+
+	// COBS: each zero byte is replaced by distance to next zero
+	uint8_t *dst = buffer;
+	*dst++ = 0;
+	uint8_t *code_ptr = dst++;
+	uint8_t code = 1;
+	for (const uint8_t *src = data; src != ptr; src++)
+	{
+		if (*src)
+		{
+			*dst++ = *src;
+			code++;
+		}
+		else
+		{
+			*code_ptr = code;
+			code_ptr = dst++;
+			code = 1;
+		}
+	}
+	*code_ptr = code;
+	*dst++ = 0;
+
+	return dst - buffer;
+}
+
+bool telemetry_decode(const uint8_t *data, unsigned size, TelemetryFrame &frame)
+{
+	uint8_t decoded[TelemetryPayloadSize + 2];
+	unsigned decoded_size = 0;
+
+	for (unsigned pos = 0; pos < size;)
+	{
+		uint8_t code = data[pos++];
+		if (code == 0) return false;
+
+		for (unsigned i = 1; i < code; i++)
+		{
+			if ((pos == size) || (data[pos] == 0) || (decoded_size == sizeof(decoded))) return false;
+			decoded[decoded_size++] = data[pos++];
+		}
+
+		if ((code != 0xFF) && (pos != size))
+		{
+			if (decoded_size == sizeof(decoded)) return false;
+			decoded[decoded_size++] = 0;
+		}
+	}
+
+	if (decoded_size != sizeof(decoded)) return false;
+
+	uint16_t crc = 0;
+	get_value(decoded + TelemetryPayloadSize, crc);
+	if (crc != telemetry_crc16(decoded, TelemetryPayloadSize)) return false;
+
+	uint8_t type = 0;
+	uint8_t state = 0;
+	const uint8_t *ptr = decoded;
+	ptr = get_value(ptr, type);
+	ptr = get_value(ptr, frame.time_ms);
+	ptr = get_value(ptr, frame.steps);
+	ptr = get_value(ptr, frame.commanded_rps);
+	ptr = get_value(ptr, frame.current_rps);
+	ptr = get_value(ptr, frame.angle_error);
+	ptr = get_value(ptr, frame.seconds_to_dither);
+	ptr = get_value(ptr, state);
+	frame.state = (TelemetryState)state;
+
+	return type == TelemetryFrameType;
+}
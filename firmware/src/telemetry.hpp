@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Binary telemetry frames. Frame payload is packed little-endian and
+   protected by CRC-16/CCITT, payload with CRC is COBS encoded and put
+   between two zero bytes, so frames can be found in UART stream mixed
+   with text messages. host/tools/telemetry_decode converts captured
+   stream into CSV */
+
+enum class TelemetryState : uint8_t
+{
+	Idle,
+	Tracking,
+	Dithering,
+	Reverting
+};
+
+struct TelemetryFrame
+{
+	uint64_t time_ms = 0;     // from start, doesn't wrap
+	int32_t steps = 0;
+	float commanded_rps = 0;  // rod rotations per second
+	float current_rps = 0;    // rod rotations per second
+	float angle_error = 0;    // arc-seconds
+	uint16_t seconds_to_dither = 0;
+	TelemetryState state = TelemetryState::Idle;
+};
+
+constexpr uint8_t TelemetryFrameType = 2;
+constexpr unsigned TelemetryPayloadSize = 28;
+constexpr unsigned TelemetryEncodedMaxSize = TelemetryPayloadSize + 2 + 1 + 2; // CRC, COBS overhead and delimiters
+
+uint16_t telemetry_crc16(const uint8_t *data, unsigned size);
+
+// Encodes frame into buffer of TelemetryEncodedMaxSize bytes. Returns encoded size
+unsigned telemetry_encode(const TelemetryFrame &frame, uint8_t *buffer);
+
+// Decodes COBS block found between zero bytes. Returns false for broken frame or not a frame
+bool telemetry_decode(const uint8_t *data, unsigned size, TelemetryFrame &frame);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <math.h>
+
+#include "config.hpp"
+#include "hardware.hpp"
+
+/* Tracker geometry. Functions are templates by floating point type to be
+   able to run tracking calculations in float or double (see TrackingFloat) */
+
+constexpr double Pi = 3.141592653589793;
+constexpr double TurnPeriod = 23.0 /*H*/ * 3600.0 + 56.0 /*M*/ * 60.0 + 4.0 /*S*/;
+constexpr double RotSpeed = 2 * Pi / TurnPeriod;
+
+// rod length (mm) for motor steps counter
+template <typename T>
+T steps_to_l(int32_t steps)
+{
+	return steps * (T)(RodStep * TurnsOnStep) + (T)StartL;
+}
+
+// motor steps counter for rod length l (nearest step)
+template <typename T>
+int32_t l_to_steps(T l)
+{
+	return (int32_t)lround((l - (T)StartL) / (T)(RodStep * TurnsOnStep));
+}
+
+// angle (in radians) for rod length l
+template <typename T>
+T calc_angle(T l)
+{
+	return 2 * asin(l / (2 * (T)R));
+}
+
+// rod length for angle (in radians)
+template <typename T>
+T calc_l(T angle)
+{
+	return 2 * (T)R * sin(angle / 2);
+}
+
+// rod speed (mm in second) by numeric differentiation of calc_l.
+// Always in double: step d_angle is lost in float precision
+inline double calc_l_speed_numeric(double l)
+{
+	double angle = calc_angle(l);
+
+	constexpr double d_angle = 1e-8;
+
+	double l1 = calc_l(angle + d_angle);
+	double l2 = calc_l(angle - d_angle);
+	double dl = l1 - l2;
+	constexpr double dt = 2 * d_angle / RotSpeed;
+	return dl / dt;
+}
+
+// rod speed (mm in second) from dl/da = R*cos(a/2), where cos(a/2) = sqrt(1 - (l/2R)^2)
+template <typename T>
+T calc_l_speed_analytic(T l)
+{
+	T half_sin = l / (2 * (T)R);
+	return (T)R * sqrt(1 - half_sin * half_sin) * (T)RotSpeed;
+}
+
+template <typename T>
+T calc_l_speed(T l)
+{
+	if constexpr (RodSpeedCalc == RodSpeedMethod::Numeric)
+		return (T)calc_l_speed_numeric(l);
+	else
+		return calc_l_speed_analytic(l);
+}